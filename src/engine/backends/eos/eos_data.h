@@ -16,6 +16,7 @@ enum class CriteriaOperator {
   EQUAL,
   NOT_EQUAL,
   ANY_OF,
+  NOT_ANY_OF,
 };
 
 struct SearchLobbiesCriteria {
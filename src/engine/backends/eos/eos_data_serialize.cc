@@ -14,6 +14,9 @@ void to_json(nlohmann::json& out, const CriteriaOperator& obj) {
     case CriteriaOperator::ANY_OF:
       out = nlohmann::json("ANY_OF");
       return;
+    case CriteriaOperator::NOT_ANY_OF:
+      out = nlohmann::json("NOT_ANY_OF");
+      return;
   }
 }
 
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace engine::backend::quake3 {
+
+// Server IPv4 address (upper 32 bits, host byte order) and port (lower 16
+// bits) packed into a single integer, used to identify servers without
+// formatting "IP:Port" strings.
+using ServerKey = uint64_t;
+
+constexpr ServerKey MakeServerKey(uint32_t ip, uint16_t port) {
+  return (static_cast<ServerKey>(ip) << 16) | port;
+}
+
+constexpr uint32_t GetServerKeyIp(ServerKey key) {
+  return static_cast<uint32_t>(key >> 16);
+}
+
+constexpr uint16_t GetServerKeyPort(ServerKey key) {
+  return static_cast<uint16_t>(key & 0xFFFF);
+}
+
+//
+// getservers
+//
+
+struct GetServersResponse {
+  std::vector<ServerKey> servers;
+  bool end_of_transmission = false;
+};
+
+//
+// getstatus / getinfo
+//
+
+struct ServerResponsePlayer {
+  int score = 0;
+  int ping = 0;
+  // Unquoted, but still with color codes.
+  std::string_view name;
+};
+
+// All views point into the parsed datagram.
+struct ServerResponse {
+  // False for `infoResponse`, which has no players.
+  bool is_status = false;
+  std::vector<std::pair<std::string_view, std::string_view>> cvars;
+  std::vector<ServerResponsePlayer> players;
+};
+
+}  // namespace engine::backend::quake3
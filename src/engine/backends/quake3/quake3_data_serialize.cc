@@ -0,0 +1,222 @@
+#include "engine/backends/quake3/quake3_data_serialize.h"
+
+#include <charconv>
+
+namespace engine::backend::quake3 {
+
+namespace {
+constexpr std::string_view kGetServersResponseHeader = "getserversResponse";
+// Entry slot which ends the list. Its prefix is also a valid address, which
+// is why only the whole slot (with a zero port) counts as the end.
+constexpr std::string_view kEndOfTransmission{"\\EOT\0\0\0", 7};
+constexpr std::string_view kStatusResponseHeader = "statusResponse\n";
+constexpr std::string_view kInfoResponseHeader = "infoResponse\n";
+
+// '\' followed by 4 bytes of IPv4 address and 2 bytes of port, both in
+// network byte order.
+constexpr size_t kGetServersEntrySize = 7;
+
+std::string_view AsStringView(std::span<const std::byte> data) {
+  return {reinterpret_cast<const char*>(data.data()), data.size()};
+}
+
+uint8_t ByteAt(std::string_view data, size_t pos) {
+  return static_cast<uint8_t>(data[pos]);
+}
+
+// Reads the next `delimiter`-terminated token from `data` at `pos`. Like
+// `std::getline()`, fails only if there is nothing left to read.
+bool NextToken(std::string_view data,
+               char delimiter,
+               size_t& pos,
+               std::string_view& token) {
+  if (pos >= data.size())
+    return false;
+
+  const size_t end = data.find(delimiter, pos);
+  if (end == std::string_view::npos) {
+    token = data.substr(pos);
+    pos = data.size();
+  } else {
+    token = data.substr(pos, end - pos);
+    pos = end + 1;
+  }
+  return true;
+}
+
+// Parses an integer preceded by optional whitespace, like `operator>>`.
+bool ConsumeInt(std::string_view& data, int& value) {
+  const size_t start = data.find_first_not_of(" \t");
+  if (start == std::string_view::npos)
+    return false;
+
+  const auto result =
+      std::from_chars(data.data() + start, data.data() + data.size(), value);
+  if (result.ec != std::errc{})
+    return false;
+  data.remove_prefix(result.ptr - data.data());
+  return true;
+}
+
+// Parses a `<score> <ping> "<name>"` line.
+bool ParsePlayerLine(std::string_view line, ServerResponsePlayer& player) {
+  if (!ConsumeInt(line, player.score) || !ConsumeInt(line, player.ping))
+    return false;
+
+  if (const size_t first = line.find_first_not_of(' ');
+      first != std::string_view::npos) {
+    line.remove_prefix(first);
+  }
+  if (line.size() >= 2 && line.front() == '"' && line.back() == '"') {
+    line = line.substr(1, line.size() - 2);
+  }
+  player.name = line;
+  return true;
+}
+}  // namespace
+
+std::string ServerKeyToString(ServerKey key) {
+  // "255.255.255.255:65535"
+  char buffer[21];
+  char* ptr = buffer;
+  char* const end = buffer + sizeof(buffer);
+
+  const uint32_t ip = GetServerKeyIp(key);
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    ptr = std::to_chars(ptr, end, (ip >> shift) & 0xFF).ptr;
+    *ptr++ = (shift > 0) ? '.' : ':';
+  }
+  ptr = std::to_chars(ptr, end, GetServerKeyPort(key)).ptr;
+
+  return std::string(buffer, ptr);
+}
+
+std::optional<ServerKey> ParseServerAddress(std::string_view address,
+                                            uint16_t default_port) {
+  const char* ptr = address.data();
+  const char* const end = address.data() + address.size();
+
+  uint32_t ip = 0;
+  for (int octet_idx = 0; octet_idx < 4; ++octet_idx) {
+    if (octet_idx > 0) {
+      if (ptr == end || *ptr != '.')
+        return std::nullopt;
+      ++ptr;
+    }
+    uint32_t octet = 0;
+    const auto result = std::from_chars(ptr, end, octet);
+    if (result.ec != std::errc{} || octet > 255)
+      return std::nullopt;
+    ip = (ip << 8) | octet;
+    ptr = result.ptr;
+  }
+
+  uint16_t port = default_port;
+  if (ptr != end) {
+    if (*ptr != ':')
+      return std::nullopt;
+    const auto result = std::from_chars(ptr + 1, end, port);
+    if (result.ec != std::errc{} || result.ptr != end)
+      return std::nullopt;
+  }
+
+  return MakeServerKey(ip, port);
+}
+
+bool ParseGetServersResponse(std::span<const std::byte> datagram,
+                             GetServersResponse* response) {
+  response->servers.clear();
+  response->end_of_transmission = false;
+
+  const std::string_view data = AsStringView(datagram);
+  size_t pos = data.find(kGetServersResponseHeader);
+  if (pos == std::string_view::npos)
+    return false;
+
+  pos += kGetServersResponseHeader.size();
+  while (pos < data.size()) {
+    const auto slot = data.substr(pos, kGetServersEntrySize);
+    // Some masters truncate the trailing zeros of the last slot.
+    if (slot == kEndOfTransmission ||
+        (slot.size() < kGetServersEntrySize && slot.size() >= 4 &&
+         kEndOfTransmission.starts_with(slot))) {
+      response->end_of_transmission = true;
+      break;
+    }
+
+    if (data[pos] == '\\' && pos + kGetServersEntrySize <= data.size()) {
+      const uint32_t ip = (uint32_t{ByteAt(data, pos + 1)} << 24) |
+                          (uint32_t{ByteAt(data, pos + 2)} << 16) |
+                          (uint32_t{ByteAt(data, pos + 3)} << 8) |
+                          uint32_t{ByteAt(data, pos + 4)};
+      const uint16_t port = static_cast<uint16_t>(
+          (ByteAt(data, pos + 5) << 8) | ByteAt(data, pos + 6));
+      if (ip != 0 && port != 0)
+        response->servers.push_back(MakeServerKey(ip, port));
+      pos += kGetServersEntrySize;
+    } else {
+      pos++;
+    }
+  }
+
+  return true;
+}
+
+bool ParseServerResponse(std::span<const std::byte> datagram,
+                         ServerResponse* response) {
+  response->is_status = false;
+  response->cvars.clear();
+  response->players.clear();
+
+  const std::string_view data = AsStringView(datagram);
+  size_t pos = data.find(kStatusResponseHeader);
+  if (pos != std::string_view::npos) {
+    response->is_status = true;
+    pos += kStatusResponseHeader.size();
+  } else {
+    pos = data.find(kInfoResponseHeader);
+    if (pos == std::string_view::npos)
+      return false;
+    pos += kInfoResponseHeader.size();
+  }
+
+  const std::string_view content = data.substr(pos);
+  const size_t cvars_end = content.find('\n');
+
+  std::string_view cvar_block = content.substr(0, cvars_end);
+  if (!cvar_block.empty() && cvar_block.front() == '\\')
+    cvar_block.remove_prefix(1);
+
+  size_t cvar_pos = 0;
+  std::string_view key, value;
+  while (NextToken(cvar_block, '\\', cvar_pos, key) &&
+         NextToken(cvar_block, '\\', cvar_pos, value)) {
+    if (!key.empty())
+      response->cvars.emplace_back(key, value);
+  }
+
+  if (!response->is_status || cvars_end == std::string_view::npos)
+    return true;
+
+  const std::string_view player_list = content.substr(cvars_end + 1);
+  size_t line_pos = 0;
+  std::string_view line;
+  while (NextToken(player_list, '\n', line_pos, line)) {
+    ServerResponsePlayer player;
+    if (!line.empty() && ParsePlayerLine(line, player))
+      response->players.push_back(player);
+  }
+
+  return true;
+}
+
+std::string_view FindCvar(const ServerResponse& response,
+                          std::string_view key) {
+  for (auto it = response.cvars.rbegin(); it != response.cvars.rend(); ++it) {
+    if (it->first == key)
+      return it->second;
+  }
+  return {};
+}
+
+}  // namespace engine::backend::quake3
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "engine/backends/quake3/quake3_data.h"
+
+namespace engine::backend::quake3 {
+
+std::string ServerKeyToString(ServerKey key);
+std::optional<ServerKey> ParseServerAddress(std::string_view address,
+                                            uint16_t default_port);
+
+// Parses a master server's `getserversResponse` datagram into `response`,
+// reusing its storage. Returns false if `datagram` isn't such a response.
+bool ParseGetServersResponse(std::span<const std::byte> datagram,
+                             GetServersResponse* response);
+
+// Parses a server's `statusResponse` or `infoResponse` datagram in a single
+// pass into `response`, reusing its storage. Returns false if `datagram`
+// isn't such a response.
+bool ParseServerResponse(std::span<const std::byte> datagram,
+                         ServerResponse* response);
+
+// Returns the value of the last `key` cvar, or an empty string if there's
+// none.
+std::string_view FindCvar(const ServerResponse& response, std::string_view key);
+
+}  // namespace engine::backend::quake3
@@ -1,13 +1,34 @@
 #include "engine/backends/quake3/quake3_master_backend.h"
 
-#include <set>
-#include <sstream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "base/logging.h"
 #include "base/threading/sequenced_task_runner_handle.h"
 #include "base/time/time_ticks.h"
+#include "engine/backends/quake3/quake3_data.h"
+#include "engine/backends/quake3/quake3_data_serialize.h"
+#include "nlohmann/json.hpp"
+#include "utils/msgpack_file.h"
 
 #include <winsock2.h>
+#include <mswsock.h>
 #include <ws2tcpip.h>
 
 namespace engine::backend {
@@ -15,18 +36,283 @@ namespace engine::backend {
 namespace {
 const auto kDetailTimeout = base::Seconds(3);
 const auto kMasterSearchTimeout = base::Seconds(3);
+const auto kPollRetryInterval = base::Milliseconds(10);
+const auto kPartialResultsInterval = base::Milliseconds(100);
+
+constexpr size_t kMaxDatagramSize = 16384;
+// Datagrams picked up at once by `DatagramReceiver`. With Registered I/O this
+// many receives are kept posted on each socket, each with a buffer of
+// `kMaxDatagramSize`, and a single `RIODequeueCompletion()` call returns up to
+// a whole batch of them.
+constexpr ULONG kReceiveBatchSize = 32;
+
+// Token bucket holds up to this much worth of the probes-per-second budget,
+// which also covers the coarse granularity of the Windows wait timers.
+const auto kProbeBurstWindow = base::Milliseconds(50);
+// Used to size `SO_RCVBUF` so that replies to all in-flight probes fit in it.
+constexpr int kExpectedStatusResponseSize = 2048;
+constexpr int kMinReceiveBufferSize = 256 * 1024;
+constexpr int kMaxReceiveBufferSize = 8 * 1024 * 1024;
+
+// Lost probes are retransmitted up to `kMaxProbeRetries` times, each time
+// after an exponentially backed-off retransmission timeout (RTO). The probe
+// still fails `kDetailTimeout` after it was first sent.
+//
+// The backed-off RTO is capped at `kMaxProbeRto`, and `kMaxProbeRetries` times
+// that must stay below `kDetailTimeout` so that every retry goes out. Without
+// RTT samples, retries go out at 1 s and 2 s, leaving the last one 1 s to be
+// answered before the 3 s timeout. With a 200 ms RTO, they go out at 200 ms
+// and 600 ms.
+constexpr int kMaxProbeRetries = 2;
+const auto kInitialProbeRto = base::Seconds(1);
+const auto kMinProbeRto = base::Milliseconds(200);
+const auto kMaxProbeRto = base::Seconds(1);
+
+// Once masters are done, a refresh finishes early if the replies it already
+// got show that the remaining probes are unlikely to be answered. This needs
+// at least `kMinTailSamples` replies to go by, and is re-evaluated every
+// `kTailCheckInterval`. `kDetailTimeout` still bounds the wait.
+constexpr size_t kMinTailSamples = 20;
+const auto kTailCheckInterval = base::Milliseconds(50);
+// The refresh finishes when fewer replies than this are still expected...
+constexpr double kMaxExpectedLateReplies = 0.5;
+// ...or when all remaining probes are pending for this many p99 RTTs.
+constexpr int64_t kTailDeadlineFactor = 2;
+
+// Estimates RTO from RTTs observed during the current refresh, following the
+// smoothed RTT and RTT variance approach from RFC 6298.
+class ProbeRtoEstimator {
+ public:
+  void Reset() { has_samples_ = false; }
+
+  void AddSample(base::TimeDelta rtt) {
+    const int64_t rtt_us = rtt.InMicroseconds();
+    if (!has_samples_) {
+      srtt_us_ = rtt_us;
+      rttvar_us_ = rtt_us / 2;
+      has_samples_ = true;
+      return;
+    }
+    const int64_t delta_us =
+        srtt_us_ > rtt_us ? srtt_us_ - rtt_us : rtt_us - srtt_us_;
+    rttvar_us_ = (3 * rttvar_us_ + delta_us) / 4;
+    srtt_us_ = (7 * srtt_us_ + rtt_us) / 8;
+  }
+
+  base::TimeDelta GetRto(int retries) const {
+    const auto rto =
+        has_samples_ ? (std::max)(base::Microseconds(srtt_us_ + 4 * rttvar_us_),
+                                  kMinProbeRto)
+                     : kInitialProbeRto;
+    return (std::min)(rto * (int64_t{1} << retries), kMaxProbeRto);
+  }
+
+ private:
+  bool has_samples_ = false;
+  int64_t srtt_us_ = 0;
+  int64_t rttvar_us_ = 0;
+};
+
+const uint16_t kDefaultServerPort = 27960;
+
+constexpr std::string_view kInfoResponseHeader = "\xff\xff\xff\xffinfoResponse";
 
-std::string SockAddrToString(const sockaddr_in& addr) {
-  char buf[INET_ADDRSTRLEN];
-  inet_ntop(AF_INET, &addr.sin_addr, buf, sizeof(buf));
-  return std::string(buf) + ":" + std::to_string(ntohs(addr.sin_port));
+// Game types can't be combined in a single query, so one is sent per game
+// type. Past this many, all game types are queried at once instead.
+constexpr size_t kMaxGameTypeQueries = 3;
+
+// Follows dpmaster's syntax, where `empty` and `full` include such servers
+// (excluded by default) and `gametype=` limits results to a single one.
+std::vector<std::string> BuildGetServersRequests(
+    const Quake3MasterFilters& filters) {
+  std::string request = "\xff\xff\xff\xffgetservers 68";
+  if (filters.include_empty)
+    request += " empty";
+  if (filters.include_full)
+    request += " full";
+
+  if (filters.game_types.empty() ||
+      filters.game_types.size() > kMaxGameTypeQueries) {
+    return {request};
+  }
+
+  std::vector<std::string> requests;
+  for (const int game_type : filters.game_types) {
+    requests.push_back(request + " gametype=" + std::to_string(game_type));
+  }
+  return requests;
+}
+
+// Both queries may be in flight for the same server at once, so pending probes
+// are keyed by the server and the query type.
+using ProbeKey = uint64_t;
+
+ProbeKey MakeProbeKey(quake3::ServerKey key, Quake3ServerQuery query) {
+  return key | (static_cast<ProbeKey>(query) << 48);
+}
+
+quake3::ServerKey GetProbeServerKey(ProbeKey probe_key) {
+  return probe_key & ((ProbeKey{1} << 48) - 1);
+}
+
+Quake3ServerQuery GetResponseQuery(std::span<const std::byte> datagram) {
+  const std::string_view data(reinterpret_cast<const char*>(datagram.data()),
+                              datagram.size());
+  return data.starts_with(kInfoResponseHeader) ? Quake3ServerQuery::kInfo
+                                               : Quake3ServerQuery::kStatus;
+}
+
+// Master servers are resolved on separate threads, as `getaddrinfo()` may
+// block for seconds. Resolved addresses are reused for `kMasterAddressTtl`,
+// so periodic refreshes don't hit the resolver every time.
+const auto kMasterAddressTtl = base::Seconds(10 * 60);
+const auto kFailedMasterAddressTtl = base::Seconds(30);
+
+// Blocking, only called on resolver threads.
+std::optional<sockaddr_in> ResolveMasterAddress(const std::string& master) {
+  size_t colon_pos = master.find(':');
+  std::string host =
+      (colon_pos != std::string::npos) ? master.substr(0, colon_pos) : master;
+  std::string port_str = (colon_pos != std::string::npos)
+                             ? master.substr(colon_pos + 1)
+                             : "27950";
+
+  struct addrinfo hints{}, *res;
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  if (getaddrinfo(host.c_str(), port_str.c_str(), &hints, &res) != 0)
+    return std::nullopt;
+
+  const sockaddr_in addr = *(sockaddr_in*)res->ai_addr;
+  freeaddrinfo(res);
+  return addr;
+}
+
+// Shared with resolver threads, which are detached and may outlive the
+// backend while stuck in `getaddrinfo()`.
+struct MasterResolverState {
+  std::mutex mutex;
+  // Set on shutdown, after which lookup results are dropped.
+  bool abandoned = false;
+  HANDLE worker_wakeup_event = nullptr;
+};
+
+void ResolveMasterOnResolverThread(
+    std::string master,
+    base::OnceCallback<void(std::optional<sockaddr_in>)> callback,
+    std::shared_ptr<MasterResolverState> state) {
+  std::optional<sockaddr_in> addr = ResolveMasterAddress(master);
+
+  std::lock_guard<std::mutex> lock(state->mutex);
+  if (state->abandoned)
+    return;
+  std::move(callback).Run(addr);
+  SetEvent(state->worker_wakeup_event);
+}
+
+// Per-server probe outcomes of past refreshes. Servers which didn't reply to
+// `kDeadServerTimeouts` refreshes in a row are skipped, except for an
+// occasional re-check whose interval doubles with each further timeout.
+const char* kServerHealthFilePath = "quake3_server_health.dat";
+const int kServerHealthVersion = 1;
+constexpr int kDeadServerTimeouts = 3;
+constexpr int64_t kDeadServerRecheckIntervalSeconds = 60 * 60;
+constexpr int64_t kMaxDeadServerRecheckIntervalSeconds = 24 * 60 * 60;
+// Records of servers that weren't probed for this long are dropped.
+constexpr int64_t kServerHealthMaxAgeSeconds = 30 * 24 * 60 * 60;
+
+struct ServerHealth {
+  int consecutive_timeouts = 0;
+  // Seconds since the Unix epoch, 0 if never.
+  int64_t last_success_time = 0;
+  int64_t last_probe_time = 0;
+};
+
+using ServerHealthMap = std::unordered_map<quake3::ServerKey, ServerHealth>;
+
+int64_t GetUnixTimeSeconds() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+bool IsDeadServer(const ServerHealth& health) {
+  return health.consecutive_timeouts >= kDeadServerTimeouts;
+}
+
+bool ShouldSkipDeadServer(const ServerHealth& health, int64_t now) {
+  if (!IsDeadServer(health))
+    return false;
+
+  const int doublings =
+      (std::min)(health.consecutive_timeouts - kDeadServerTimeouts, 8);
+  const int64_t recheck_interval =
+      (std::min)(kDeadServerRecheckIntervalSeconds << doublings,
+                 kMaxDeadServerRecheckIntervalSeconds);
+  return now - health.last_probe_time < recheck_interval;
+}
+
+ServerHealthMap LoadServerHealth() {
+  const auto json = util::ReadMsgpackFile(kServerHealthFilePath);
+  if (!json)
+    return {};
+
+  try {
+    if (json->value("version", 0) != kServerHealthVersion)
+      return {};
+
+    // Each server is stored as an array of:
+    //   [key, consecutive_timeouts, last_success_time, last_probe_time]
+    // Files saved by older versions may have more (ignored) elements.
+    ServerHealthMap servers;
+    for (const auto& server : json->at("servers")) {
+      servers[server.at(0).get<quake3::ServerKey>()] = ServerHealth{
+          server.at(1).get<int>(),
+          server.at(2).get<int64_t>(),
+          server.at(3).get<int64_t>(),
+      };
+    }
+    return servers;
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to load Quake 3 server health: " << e.what();
+    return {};
+  }
+}
+
+// Runs on `Quake3MasterBackendImpl::io_thread_`, so that the receive worker
+// isn't blocked on disk I/O.
+void SaveServerHealth(ServerHealthMap servers) {
+  auto servers_json = nlohmann::json::array();
+  for (const auto& [key, health] : servers) {
+    servers_json.push_back(nlohmann::json::array({
+        key,
+        health.consecutive_timeouts,
+        health.last_success_time,
+        health.last_probe_time,
+    }));
+  }
+  util::WriteMsgpackFile(kServerHealthFilePath,
+                         nlohmann::json{
+                             {"version", kServerHealthVersion},
+                             {"servers", std::move(servers_json)},
+                         });
 }
 
-bool AreSockAddrEqual(const sockaddr_in& a, const sockaddr_in& b) {
-  return a.sin_addr.s_addr == b.sin_addr.s_addr && a.sin_port == b.sin_port;
+quake3::ServerKey SockAddrToServerKey(const sockaddr_in& addr) {
+  return quake3::MakeServerKey(ntohl(addr.sin_addr.s_addr),
+                               ntohs(addr.sin_port));
 }
 
-std::string MapGameType(const std::string& type) {
+sockaddr_in ServerKeyToSockAddr(quake3::ServerKey key) {
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(quake3::GetServerKeyIp(key));
+  addr.sin_port = htons(quake3::GetServerKeyPort(key));
+  return addr;
+}
+
+std::string MapGameType(std::string_view type) {
   if (type == "0")
     return "FFA";
   if (type == "1")
@@ -48,23 +334,549 @@ std::string MapGameType(const std::string& type) {
   return "Unknown";
 }
 
+// Byte classes used by `CleanQuake3String()`, matching `std::isalnum()` and
+// `std::isprint()` in the "C" locale.
+constexpr uint8_t kPrintableChar = 1 << 0;
+constexpr uint8_t kColorCodeChar = 1 << 1;
+
+constexpr std::array<uint8_t, 256> kQuake3CharClasses = [] {
+  std::array<uint8_t, 256> classes{};
+  for (int c = 0x20; c < 0x7F; ++c)
+    classes[c] |= kPrintableChar;
+  for (int c = '0'; c <= '9'; ++c)
+    classes[c] |= kColorCodeChar;
+  for (int c = 'A'; c <= 'Z'; ++c)
+    classes[c] |= kColorCodeChar;
+  for (int c = 'a'; c <= 'z'; ++c)
+    classes[c] |= kColorCodeChar;
+  return classes;
+}();
+
 // This function processess a valid Quake 3 string (e.g. player name) and strips
 // it from unwanted parts (e.g. color specifiers).
-std::string CleanQuake3String(const std::string& input) {
-  std::string output;
+std::string CleanQuake3String(std::string_view input) {
+  // Output is never longer than input, so it's written in place and trimmed.
+  std::string output(input.size(), ' ');
+  size_t output_size = 0;
   for (size_t i = 0; i < input.size(); ++i) {
-    if (input[i] == '^' && i + 1 < input.size() && std::isalnum(input[i + 1])) {
+    const auto c = static_cast<unsigned char>(input[i]);
+    if (c == '^' && i + 1 < input.size() &&
+        (kQuake3CharClasses[static_cast<unsigned char>(input[i + 1])] &
+         kColorCodeChar)) {
       i++;
       continue;
     }
-    unsigned char c = static_cast<unsigned char>(input[i]);
-    if (!std::isprint(c))
-      output += ' ';
-    else
-      output += input[i];
+    output[output_size++] =
+        (kQuake3CharClasses[c] & kPrintableChar) ? input[i] : ' ';
   }
+  output.resize(output_size);
   return output;
 }
+
+// Parses `std::stoi()`-like, returning `fallback` on failure.
+int ParseInt(std::string_view value, int fallback) {
+  const size_t start = value.find_first_not_of(" \t");
+  if (start == std::string_view::npos)
+    return fallback;
+
+  int result = fallback;
+  if (std::from_chars(value.data() + start, value.data() + value.size(),
+                      result)
+          .ec != std::errc{}) {
+    return fallback;
+  }
+  return result;
+}
+
+// Parses both `statusResponse` and `infoResponse` replies. `parsed` is only
+// used as scratch space, to reuse its storage across responses. `ping` is left
+// for the caller to fill in.
+std::optional<Quake3ServerResult> ParseServerResponse(
+    quake3::ServerKey server_key,
+    std::span<const std::byte> datagram,
+    quake3::ServerResponse* parsed) {
+  if (!quake3::ParseServerResponse(datagram, parsed))
+    return std::nullopt;
+
+  Quake3ServerResult result;
+  result.address = quake3::ServerKeyToString(server_key);
+
+  const auto hostname = quake3::FindCvar(*parsed, "sv_hostname");
+  result.hostname = CleanQuake3String(hostname);
+  if (result.hostname.empty())
+    result.hostname = hostname;
+  if (result.hostname.empty())
+    result.hostname = "Unnamed Server";
+
+  const auto map = quake3::FindCvar(*parsed, "mapname");
+  result.map = CleanQuake3String(map);
+  if (result.map.empty())
+    result.map = map;
+  if (result.map.empty())
+    result.map = "Unknown Map";
+
+  result.max_players = ParseInt(quake3::FindCvar(*parsed, "sv_maxclients"), 0);
+
+  if (parsed->is_status) {
+    result.members.reserve(parsed->players.size());
+    int humans = 0;
+    for (const auto& player : parsed->players) {
+      result.members.push_back(
+          {player.score, player.ping, CleanQuake3String(player.name)});
+      if (player.ping > 0)
+        humans++;
+    }
+    result.players = static_cast<int>(result.members.size());
+    result.humans = humans;
+    result.game_type = MapGameType(quake3::FindCvar(*parsed, "g_gametype"));
+  } else {
+    // `getinfo` reports counts only. Older servers don't report humans.
+    result.players = ParseInt(quake3::FindCvar(*parsed, "clients"), 0);
+    const auto humans = quake3::FindCvar(*parsed, "g_humanplayers");
+    if (!humans.empty()) {
+      if (int value = ParseInt(humans, -1); value >= 0)
+        result.humans = value;
+    }
+    result.game_type = MapGameType(quake3::FindCvar(*parsed, "gametype"));
+    result.has_members = false;
+  }
+
+  return result;
+}
+
+struct ReceivedDatagram {
+  sockaddr_in from;
+  int size = 0;
+  base::TimeTicks received_time;
+  std::array<char, kMaxDatagramSize> data;
+};
+
+// Reads the next datagram from non-blocking `sock` into `datagram`,
+// timestamping it on arrival. Returns false if there was none.
+bool ReceiveDatagram(SOCKET sock, ReceivedDatagram& datagram) {
+  int from_len = sizeof(datagram.from);
+  datagram.size =
+      recvfrom(sock, datagram.data.data(), (int)datagram.data.size(), 0,
+               (sockaddr*)&datagram.from, &from_len);
+  if (datagram.size <= 0)
+    return false;
+  datagram.received_time = base::TimeTicks::Now();
+  return true;
+}
+
+std::span<const std::byte> AsBytes(const ReceivedDatagram& datagram) {
+  return std::as_bytes(std::span(datagram.data.data(), datagram.size));
+}
+
+// Creates a UDP socket that supports Registered I/O where available, which
+// Windows versions before 8 don't.
+SOCKET CreateProbeSocket() {
+  SOCKET sock = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, nullptr, 0,
+                           WSA_FLAG_REGISTERED_IO);
+  if (sock == INVALID_SOCKET)
+    sock = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  return sock;
+}
+
+// Receives datagrams from a UDP socket in batches. With Registered I/O (RIO),
+// `kReceiveBatchSize` receives into a registered buffer ring are kept posted,
+// and completed ones are picked up a batch per `RIODequeueCompletion()` call
+// instead of a `recvfrom()` per datagram. Falls back to the latter if RIO isn't
+// available.
+//
+// Probes are still sent with `sendto()`, as they're paced out a few at a time
+// (see `FlushQueuedProbesOnWorker()`), so there's little to batch there.
+class DatagramReceiver {
+ public:
+  DatagramReceiver();
+  ~DatagramReceiver();
+
+  DatagramReceiver(const DatagramReceiver&) = delete;
+  DatagramReceiver& operator=(const DatagramReceiver&) = delete;
+
+  // Switches `sock` (from `CreateProbeSocket()`) to non-blocking mode and
+  // starts receiving on it. `event` is signaled when datagrams are pending.
+  bool Initialize(SOCKET sock, WSAEVENT event);
+  // Releases RIO resources. Must be called after the socket is closed, before
+  // `WSACleanup()`.
+  void Shutdown();
+
+  // Reads all pending datagrams and runs
+  // `on_datagram(from, datagram, received_time)` for each. Datagrams of a
+  // single batch share their `received_time`.
+  template <typename OnDatagram>
+  void ReceiveAll(OnDatagram on_datagram);
+
+ private:
+  static constexpr size_t kSlotSize = kMaxDatagramSize + sizeof(SOCKADDR_INET);
+
+  bool InitializeRio();
+  bool PostReceive(ULONG slot, DWORD flags);
+  char* GetSlotData(ULONG slot) { return buffer_.data() + slot * kSlotSize; }
+  const SOCKADDR_INET& GetSlotAddress(ULONG slot) const {
+    return *reinterpret_cast<const SOCKADDR_INET*>(
+        buffer_.data() + slot * kSlotSize + kMaxDatagramSize);
+  }
+
+  SOCKET sock_ = INVALID_SOCKET;
+  WSAEVENT event_ = WSA_INVALID_EVENT;
+
+  bool use_rio_ = false;
+  RIO_EXTENSION_FUNCTION_TABLE rio_{};
+  RIO_BUFFERID buffer_id_ = RIO_INVALID_BUFFERID;
+  RIO_CQ completion_queue_ = RIO_INVALID_CQ;
+  RIO_RQ request_queue_ = RIO_INVALID_RQ;
+  // Registered with RIO. Each slot holds a datagram, followed by its source
+  // address.
+  std::vector<char> buffer_;
+  std::array<RIORESULT, kReceiveBatchSize> results_;
+
+  // Reused across reads without RIO, to avoid allocating per datagram.
+  ReceivedDatagram received_datagram_;
+};
+
+DatagramReceiver::DatagramReceiver() = default;
+
+DatagramReceiver::~DatagramReceiver() = default;
+
+bool DatagramReceiver::Initialize(SOCKET sock, WSAEVENT event) {
+  sock_ = sock;
+  event_ = event;
+
+  GUID function_table_id = WSAID_MULTIPLE_RIO;
+  DWORD bytes = 0;
+  rio_.cbSize = sizeof(rio_);
+  if (WSAIoctl(sock_, SIO_GET_MULTIPLE_EXTENSION_FUNCTION_POINTER,
+               &function_table_id, sizeof(function_table_id), &rio_,
+               sizeof(rio_), &bytes, nullptr, nullptr) == SOCKET_ERROR) {
+    LOG(INFO) << "Registered I/O isn't available, receiving datagrams one "
+                 "at a time";
+    // This also switches the socket to non-blocking mode.
+    return WSAEventSelect(sock_, event_, FD_READ) != SOCKET_ERROR;
+  }
+
+  use_rio_ = true;
+  if (!InitializeRio()) {
+    LOG(ERROR) << "Failed to set up Registered I/O: " << WSAGetLastError();
+    return false;
+  }
+  return true;
+}
+
+bool DatagramReceiver::InitializeRio() {
+  u_long non_blocking = 1;
+  if (ioctlsocket(sock_, FIONBIO, &non_blocking) == SOCKET_ERROR)
+    return false;
+
+  buffer_.resize(kReceiveBatchSize * kSlotSize);
+  buffer_id_ = rio_.RIORegisterBuffer(buffer_.data(),
+                                      static_cast<DWORD>(buffer_.size()));
+  if (buffer_id_ == RIO_INVALID_BUFFERID)
+    return false;
+
+  RIO_NOTIFICATION_COMPLETION notification{};
+  notification.Type = RIO_EVENT_COMPLETION;
+  notification.Event.EventHandle = event_;
+  notification.Event.NotifyReset = TRUE;
+  // Sends don't go through RIO, but the request queue needs room for one.
+  completion_queue_ =
+      rio_.RIOCreateCompletionQueue(kReceiveBatchSize + 1, &notification);
+  if (completion_queue_ == RIO_INVALID_CQ)
+    return false;
+  request_queue_ =
+      rio_.RIOCreateRequestQueue(sock_, kReceiveBatchSize, 1, 1, 1,
+                                 completion_queue_, completion_queue_, nullptr);
+  if (request_queue_ == RIO_INVALID_RQ)
+    return false;
+
+  for (ULONG slot = 0; slot < kReceiveBatchSize; ++slot) {
+    const bool last = slot + 1 == kReceiveBatchSize;
+    if (!PostReceive(slot, last ? 0 : RIO_MSG_DEFER))
+      return false;
+  }
+  return rio_.RIONotify(completion_queue_) == ERROR_SUCCESS;
+}
+
+void DatagramReceiver::Shutdown() {
+  // The request queue is freed along with the socket.
+  if (completion_queue_ != RIO_INVALID_CQ) {
+    rio_.RIOCloseCompletionQueue(completion_queue_);
+    completion_queue_ = RIO_INVALID_CQ;
+  }
+  if (buffer_id_ != RIO_INVALID_BUFFERID) {
+    rio_.RIODeregisterBuffer(buffer_id_);
+    buffer_id_ = RIO_INVALID_BUFFERID;
+  }
+  request_queue_ = RIO_INVALID_RQ;
+}
+
+bool DatagramReceiver::PostReceive(ULONG slot, DWORD flags) {
+  RIO_BUF data{buffer_id_, static_cast<ULONG>(slot * kSlotSize),
+               static_cast<ULONG>(kMaxDatagramSize)};
+  RIO_BUF address{buffer_id_,
+                  static_cast<ULONG>(slot * kSlotSize + kMaxDatagramSize),
+                  static_cast<ULONG>(sizeof(SOCKADDR_INET))};
+  const auto context = reinterpret_cast<PVOID>(static_cast<ULONG_PTR>(slot));
+  if (!rio_.RIOReceiveEx(request_queue_, &data, 1, nullptr, &address, nullptr,
+                         nullptr, flags, context)) {
+    LOG(ERROR) << "Failed to post UDP receive: " << WSAGetLastError();
+    return false;
+  }
+  return true;
+}
+
+template <typename OnDatagram>
+void DatagramReceiver::ReceiveAll(OnDatagram on_datagram) {
+  if (!use_rio_) {
+    // Reset before draining - any datagram arriving after the last
+    // `recvfrom()` below will signal the event again.
+    WSAResetEvent(event_);
+    while (ReceiveDatagram(sock_, received_datagram_)) {
+      on_datagram(received_datagram_.from, AsBytes(received_datagram_),
+                  received_datagram_.received_time);
+    }
+    return;
+  }
+
+  if (completion_queue_ == RIO_INVALID_CQ)
+    return;
+
+  // Completed slots are posted again right away, so that datagrams still in
+  // `SO_RCVBUF` fill them while the batch is being processed.
+  while (true) {
+    const ULONG count = rio_.RIODequeueCompletion(
+        completion_queue_, results_.data(), kReceiveBatchSize);
+    if (count == RIO_CORRUPT_CQ) {
+      LOG(ERROR) << "UDP receive completion queue is corrupted";
+      return;
+    }
+    if (count == 0)
+      break;
+
+    const auto received_time = base::TimeTicks::Now();
+    for (ULONG idx = 0; idx < count; ++idx) {
+      const auto& result = results_[idx];
+      const auto slot = static_cast<ULONG>(result.RequestContext);
+      // Failed receives, e.g. ICMP port unreachable reported as
+      // `WSAECONNRESET`, are just posted again.
+      const auto& from = GetSlotAddress(slot);
+      if (result.Status == 0 && from.si_family == AF_INET) {
+        on_datagram(from.Ipv4,
+                    std::as_bytes(std::span(GetSlotData(slot),
+                                            result.BytesTransferred)),
+                    received_time);
+      }
+      PostReceive(slot, idx + 1 < count ? RIO_MSG_DEFER : 0);
+    }
+  }
+
+  // Signals the event once more completions are queued, or right away if
+  // some arrived since the last dequeue.
+  rio_.RIONotify(completion_queue_);
+}
+
+void SetReceiveBufferSize(SOCKET sock, int buffer_size) {
+  if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char*)&buffer_size,
+                 sizeof(buffer_size)) == SOCKET_ERROR) {
+    LOG(WARNING) << "Failed to set UDP receive buffer size: "
+                 << WSAGetLastError();
+  }
+}
+
+// Runs with nothing if the probe timed out or the reply wasn't valid. `rtt` is
+// only set along with a server.
+using ProbeCallback =
+    base::OnceCallback<void(std::optional<Quake3ServerResult> server,
+                            base::TimeDelta rtt)>;
+
+// Ping samples are `getinfo` queries with a challenge made of this prefix and
+// a sequence number, which servers echo back in `infoResponse`. This matches
+// each reply with its own sample even if several are in flight.
+constexpr std::string_view kPingChallengePrefix = "lbping";
+constexpr int kMaxPingSamples = 5;
+const auto kPingSampleTimeout = base::Seconds(1);
+
+std::string BuildPingRequest(uint32_t token) {
+  return "\xff\xff\xff\xffgetinfo " + std::string(kPingChallengePrefix) +
+         std::to_string(token);
+}
+
+std::optional<uint32_t> ParsePingToken(std::string_view challenge) {
+  if (!challenge.starts_with(kPingChallengePrefix))
+    return std::nullopt;
+  challenge.remove_prefix(kPingChallengePrefix.size());
+
+  uint32_t token = 0;
+  const auto [ptr, ec] = std::from_chars(
+      challenge.data(), challenge.data() + challenge.size(), token);
+  if (ec != std::errc() || ptr != challenge.data() + challenge.size())
+    return std::nullopt;
+  return token;
+}
+
+// Parsed reply to a probe, not yet matched with the pending probe.
+struct ProbeReply {
+  quake3::ServerKey from;
+  Quake3ServerQuery query;
+  base::TimeTicks received_time;
+  std::optional<Quake3ServerResult> server;
+  // Set for replies to ping samples.
+  std::optional<uint32_t> ping_token;
+  // Set once matched with the pending probe, at the full precision of
+  // `received_time`.
+  base::TimeDelta rtt;
+};
+
+ProbeReply ParseProbeReply(quake3::ServerKey from,
+                           std::span<const std::byte> datagram,
+                           base::TimeTicks received_time,
+                           quake3::ServerResponse* parsed) {
+  ProbeReply reply{
+      from,
+      GetResponseQuery(datagram),
+      received_time,
+      ParseServerResponse(from, datagram, parsed),
+      std::nullopt,
+      {},
+  };
+  if (reply.server)
+    reply.ping_token = ParsePingToken(quake3::FindCvar(*parsed, "challenge"));
+  return reply;
+}
+
+// Servers are spread across shards by address, so that all probes of a server
+// use the same socket.
+size_t GetShardIndex(quake3::ServerKey key, size_t shard_count) {
+  return ((key * 0x9E3779B97F4A7C15ULL) >> 32) % shard_count;
+}
+
+constexpr int kMaxReceiveThreads = 8;
+
+// Receives and parses replies to probes sent from its own socket on its own
+// thread, so that parsing of large refreshes isn't limited to a single core.
+// Replies are passed back to the main worker in batches.
+class ProbeReceiveShard {
+ public:
+  // `on_replies_callback` is run on the shard's thread, after which
+  // `worker_wakeup_event` is signaled.
+  ProbeReceiveShard(
+      base::RepeatingCallback<void(std::vector<ProbeReply>)>
+          on_replies_callback,
+      HANDLE worker_wakeup_event);
+  ~ProbeReceiveShard();
+
+  // INVALID_SOCKET if the shard failed to initialize.
+  SOCKET socket() const { return sock_; }
+
+ private:
+  void PollOnThread();
+  void ShutdownOnThread();
+
+  base::RepeatingCallback<void(std::vector<ProbeReply>)> on_replies_callback_;
+  HANDLE worker_wakeup_event_;
+
+  base::Thread thread_;
+  SOCKET sock_ = INVALID_SOCKET;
+  WSAEVENT socket_event_ = WSA_INVALID_EVENT;
+  HANDLE wakeup_event_ = nullptr;
+  std::atomic<bool> shutting_down_{false};
+
+  DatagramReceiver receiver_;
+  quake3::ServerResponse parsed_response_;
+
+  base::WeakPtr<ProbeReceiveShard> weak_this_;
+  base::WeakPtrFactory<ProbeReceiveShard> weak_factory_;
+};
+
+ProbeReceiveShard::ProbeReceiveShard(
+    base::RepeatingCallback<void(std::vector<ProbeReply>)> on_replies_callback,
+    HANDLE worker_wakeup_event)
+    : on_replies_callback_(std::move(on_replies_callback)),
+      worker_wakeup_event_(worker_wakeup_event),
+      weak_factory_(this) {
+  weak_this_ = weak_factory_.GetWeakPtr();
+  wakeup_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+  sock_ = CreateProbeSocket();
+  if (sock_ == INVALID_SOCKET) {
+    LOG(ERROR) << "Failed to create UDP socket: " << WSAGetLastError();
+    return;
+  }
+
+  socket_event_ = WSACreateEvent();
+  if (socket_event_ == WSA_INVALID_EVENT ||
+      !receiver_.Initialize(sock_, socket_event_)) {
+    LOG(ERROR) << "Failed to start receiving on UDP socket: "
+               << WSAGetLastError();
+    closesocket(sock_);
+    sock_ = INVALID_SOCKET;
+    receiver_.Shutdown();
+    return;
+  }
+
+  thread_.Start();
+  thread_.TaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&ProbeReceiveShard::PollOnThread, weak_this_));
+}
+
+ProbeReceiveShard::~ProbeReceiveShard() {
+  shutting_down_ = true;
+  SetEvent(wakeup_event_);
+  // The thread is only started if initialization succeeded.
+  if (sock_ != INVALID_SOCKET) {
+    thread_.Stop(FROM_HERE,
+                 base::BindOnce(&ProbeReceiveShard::ShutdownOnThread,
+                                weak_this_));
+  }
+  if (socket_event_ != WSA_INVALID_EVENT)
+    WSACloseEvent(socket_event_);
+  CloseHandle(wakeup_event_);
+}
+
+void ProbeReceiveShard::PollOnThread() {
+  if (shutting_down_)
+    return;
+
+  std::vector<ProbeReply> replies;
+  receiver_.ReceiveAll([&](const sockaddr_in& from,
+                           std::span<const std::byte> datagram,
+                           base::TimeTicks received_time) {
+    replies.push_back(ParseProbeReply(SockAddrToServerKey(from), datagram,
+                                      received_time, &parsed_response_));
+  });
+
+  if (!replies.empty()) {
+    on_replies_callback_.Run(std::move(replies));
+    SetEvent(worker_wakeup_event_);
+  }
+
+  const WSAEVENT events[] = {socket_event_, wakeup_event_};
+  if (WSAWaitForMultipleEvents(static_cast<DWORD>(std::size(events)), events,
+                               FALSE, WSA_INFINITE,
+                               FALSE) == WSA_WAIT_FAILED) {
+    LOG(ERROR) << "Failed to wait for UDP socket events: "
+               << WSAGetLastError();
+    thread_.TaskRunner()->PostDelayedTask(
+        FROM_HERE, base::BindOnce(&ProbeReceiveShard::PollOnThread, weak_this_),
+        kPollRetryInterval);
+    return;
+  }
+
+  thread_.TaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&ProbeReceiveShard::PollOnThread, weak_this_));
+}
+
+void ProbeReceiveShard::ShutdownOnThread() {
+  if (sock_ != INVALID_SOCKET) {
+    closesocket(sock_);
+    sock_ = INVALID_SOCKET;
+  }
+  receiver_.Shutdown();
+  if (socket_event_ != WSA_INVALID_EVENT) {
+    WSACloseEvent(socket_event_);
+    socket_event_ = WSA_INVALID_EVENT;
+  }
+}
 }  // namespace
 
 //
@@ -76,60 +888,247 @@ class Quake3MasterBackendImpl : public Quake3MasterBackend {
   Quake3MasterBackendImpl();
   ~Quake3MasterBackendImpl() override;
 
-  void SearchServers(const std::vector<std::string>& master_servers,
-                     base::OnceCallback<void(Quake3MasterSearchResponse)>
-                         on_done_callback) override;
+  void SearchServers(
+      const std::vector<std::string>& master_servers,
+      const Quake3MasterFilters& filters,
+      const std::vector<Quake3KnownServer>& known_servers,
+      base::RepeatingCallback<void(std::vector<Quake3ServerResult>)>
+          on_partial_results_callback,
+      base::OnceCallback<void(Quake3MasterSearchResponse)> on_done_callback)
+      override;
+
+  void SetProbeSettings(Quake3ProbeSettings settings) override;
 
-  void GetServerDetails(const std::string& server_address,
-                        base::OnceCallback<void(base::net::ResourceResponse)>
-                            on_done_callback) override;
+  void GetServerDetails(
+      const std::string& server_address,
+      base::OnceCallback<void(std::optional<Quake3ServerResult>)>
+          on_done_callback) override;
 
  private:
+  struct MasterAddress {
+    // Empty if resolution failed.
+    std::optional<sockaddr_in> addr;
+    base::TimeTicks expiry_time;
+    bool resolving = false;
+  };
+
+  struct PendingPing {
+    int refresh_id;
+    quake3::ServerKey key;
+    // Null until sent.
+    base::TimeTicks send_time;
+  };
+
   struct PendingRequest {
-    std::vector<base::OnceCallback<void(base::net::ResourceResponse)>>
-        callbacks;
+    std::vector<ProbeCallback> callbacks;
+    // Time of the first send, used for the overall timeout.
     base::TimeTicks start_time;
+    // RTT is measured from this, so that retransmission backoff isn't
+    // counted in it.
+    base::TimeTicks last_send_time;
     sockaddr_in addr;
+    Quake3ServerQuery query = Quake3ServerQuery::kStatus;
+    // False while the probe waits in `queued_probes_` for its turn.
+    bool sent = false;
+    int retries = 0;
+    bool retransmit_queued = false;
+    // Set for probes of refreshes, whose outcome updates `server_health_`.
+    bool tracks_health = false;
   };
 
+  // Refreshes may overlap, e.g. an auto-search and a manual one. They share
+  // `pending_requests_` and in-progress master queries, so the overlap costs
+  // no extra packets.
   struct ActiveRefresh {
+    int id = 0;
     base::OnceCallback<void(Quake3MasterSearchResponse)> callback;
+    base::RepeatingCallback<void(std::vector<Quake3ServerResult>)>
+        partial_results_callback;
+    // Number of `response.servers` already passed to the callback above.
+    size_t delivered_servers_count = 0;
+    base::TimeTicks last_partial_delivery_time;
     base::TimeTicks start_time;
-    std::set<std::string> seen_addresses;
+    std::unordered_set<quake3::ServerKey> seen_addresses;
     Quake3MasterSearchResponse response;
 
     struct MasterState {
       sockaddr_in addr;
+      quake3::ServerKey key;
       bool got_eot = false;
+      // Number of `master_requests` whose response didn't end yet.
+      int pending_responses = 0;
+      // Listed so far, for refreshes joining this master's query later.
+      std::vector<quake3::ServerKey> servers;
     };
     std::vector<MasterState> masters;
+    // Masters whose address is still being resolved.
+    std::vector<std::string> unresolved_masters;
+    // `getservers` requests sent to each master, one per filtered game type.
+    std::vector<std::string> master_requests;
     bool master_search_finished = false;
-    int pending_details_count = 0;
+
+    Quake3ServerQuery query = Quake3ServerQuery::kStatus;
+    // Servers whose probe didn't complete yet.
+    std::unordered_set<quake3::ServerKey> pending_servers;
+
+    // Servers that replied, held back until their ping samples complete or
+    // the refresh is finalized, whichever comes first.
+    struct PingState {
+      Quake3ServerResult server;
+      std::vector<int64_t> rtts_us;
+      int remaining_samples = 0;
+    };
+    std::unordered_map<quake3::ServerKey, PingState> pinging_servers;
+    // Servers whose ping the caller already knows, not sent ping samples.
+    std::unordered_set<quake3::ServerKey> known_ping_servers;
+    // Caller's round trip time estimates, used to probe nearby servers first.
+    std::unordered_map<quake3::ServerKey, int> known_rtts_ms;
+    // Sorted lazily by `IsInRefreshTailOnWorker()`.
+    std::vector<int64_t> reply_rtts_us;
+    bool reply_rtts_sorted = true;
+    int failed_probes_count = 0;
+    // Dead servers that weren't probed at all.
+    int skipped_probes_count = 0;
+    base::TimeTicks next_tail_check_time;
+    // Set once `callback` ran. Replies arriving after that are only passed to
+    // `partial_results_callback`, until all probes complete.
+    bool finalized = false;
   };
 
+  void PostTaskToWorker(base::OnceClosure task);
+
   void InitializeOnWorker();
   void ShutdownOnWorker();
+  void SetProbeSettingsOnWorker(Quake3ProbeSettings settings);
+  void UpdateReceiveBufferSizeOnWorker();
+  void UpdateReceiveShardsOnWorker();
   void SearchServersOnWorker(
       const std::vector<std::string> master_servers,
+      const Quake3MasterFilters& filters,
+      const std::vector<Quake3KnownServer>& known_servers,
+      base::RepeatingCallback<void(std::vector<Quake3ServerResult>)>
+          partial_results_callback,
       base::OnceCallback<void(Quake3MasterSearchResponse)> callback);
   void SendDetailsRequestOnWorker(
       std::string address,
-      base::OnceCallback<void(base::net::ResourceResponse)> callback);
+      base::OnceCallback<void(std::optional<Quake3ServerResult>)> callback);
+  // Probes are sent in order of `rtt_ms` if it's known, otherwise in FIFO
+  // order, or after all others with `low_priority`.
+  void StartProbeOnWorker(quake3::ServerKey key,
+                          Quake3ServerQuery query,
+                          bool low_priority,
+                          bool tracks_health,
+                          std::optional<int> rtt_ms,
+                          ProbeCallback callback);
   void PollOnWorker();
+  void ReceivePacketsOnWorker();
+  void ProcessTimeoutsOnWorker();
+  void FlushQueuedProbesOnWorker();
+  std::optional<ProbeKey> PopQueuedProbeOnWorker();
+  void SendProbeOnWorker(PendingRequest& pending);
+  SOCKET GetProbeSocketOnWorker(const sockaddr_in& addr) const;
+  void RefillProbeTokensOnWorker(base::TimeTicks now);
+  std::optional<base::TimeTicks> GetNextDeadlineOnWorker() const;
+  bool WaitForEventsOnWorker(std::optional<base::TimeTicks> deadline);
   void DispatchPacketOnWorker(const sockaddr_in& from,
-                              const char* buffer,
-                              int received);
-  void FinalizeRefreshIfReadyOnWorker(bool force = false);
-
-  void OnInternalDetailResponse(std::string address,
-                                base::net::ResourceResponse response);
+                              std::span<const std::byte> datagram,
+                              base::TimeTicks received_time);
+  void OnShardRepliesOnWorker(std::vector<ProbeReply> replies);
+  void DispatchProbeReplyOnWorker(ProbeReply reply);
+  void ResolveMasterOnWorker(const std::string& master);
+  void OnMasterResolvedOnWorker(std::string master,
+                                std::optional<sockaddr_in> addr);
+  void AddMasterToRefreshOnWorker(ActiveRefresh& refresh,
+                                  const sockaddr_in& addr);
+  void UpdateMasterSearchFinishedOnWorker(ActiveRefresh& refresh);
+  void OnMasterResponseOnWorker(ActiveRefresh& refresh,
+                                ActiveRefresh::MasterState& master,
+                                const quake3::GetServersResponse& response);
+  const ActiveRefresh::MasterState* FindMasterQueryInProgressOnWorker(
+      quake3::ServerKey key,
+      const std::vector<std::string>& requests) const;
+  ActiveRefresh* FindRefreshOnWorker(int refresh_id);
+  void StartRefreshProbeOnWorker(ActiveRefresh& refresh, quake3::ServerKey key);
+  void QueuePingSampleOnWorker(int refresh_id, quake3::ServerKey key);
+  void SendPingSampleOnWorker(uint32_t token, PendingPing& ping);
+  void OnPingSampleOnWorker(int refresh_id,
+                            quake3::ServerKey key,
+                            std::optional<base::TimeDelta> rtt);
+  static Quake3ServerResult TakeSampledServer(ActiveRefresh::PingState& state);
+  void DeliverPartialResultsOnWorker();
+  bool IsInRefreshTailOnWorker(ActiveRefresh& refresh, base::TimeTicks now);
+  void FinalizeRefreshesIfReadyOnWorker();
+  void RecordProbeOutcomeOnWorker(ProbeKey probe_key, bool replied);
+  void UpdateServerHealthOnWorker();
+
+  void OnInternalDetailResponse(int refresh_id,
+                                quake3::ServerKey server_key,
+                                std::optional<Quake3ServerResult> server,
+                                base::TimeDelta rtt);
 
   base::Thread worker_thread_;
+  std::shared_ptr<MasterResolverState> resolver_state_;
+  // Writes `server_health_` to disk.
+  base::Thread io_thread_;
   SOCKET sock_ = INVALID_SOCKET;
 
-  // Maps address string "IP:Port" to pending request
-  std::map<std::string, PendingRequest> pending_requests_;
-  std::unique_ptr<ActiveRefresh> active_refresh_;
+  // Signaled by `receiver_` when datagrams are pending on `sock_`.
+  WSAEVENT socket_event_ = WSA_INVALID_EVENT;
+  // Signaled from any thread to interrupt the readiness wait in the worker
+  // loop, e.g. when a new task is posted or the backend is shutting down.
+  HANDLE wakeup_event_ = nullptr;
+  std::atomic<bool> shutting_down_{false};
+
+  DatagramReceiver receiver_;
+
+  // Additional sockets that probes are spread across, when more than one
+  // receive thread is configured. `sock_` takes the first share of servers.
+  std::vector<std::unique_ptr<ProbeReceiveShard>> shards_;
+
+  // Reused across master responses to avoid allocating per datagram.
+  quake3::GetServersResponse parsed_master_response_;
+  quake3::ServerResponse parsed_server_response_;
+
+  std::unordered_map<ProbeKey, PendingRequest> pending_requests_;
+  // Keys of `pending_requests_` whose probe wasn't sent yet. These are paced
+  // out by `FlushQueuedProbesOnWorker()`, nearest servers (by the caller's
+  // round trip time estimate) first, alternating with servers of unknown
+  // distance in FIFO order.
+  std::priority_queue<std::pair<int, ProbeKey>,
+                      std::vector<std::pair<int, ProbeKey>>,
+                      std::greater<>>
+      queued_ranked_probes_;
+  std::deque<ProbeKey> queued_probes_;
+  bool next_queued_probe_ranked_ = true;
+  // Sent only once both queues above are empty. Used for servers which didn't
+  // reply recently.
+  std::deque<ProbeKey> queued_low_priority_probes_;
+  // Keys of in-flight `pending_requests_` that timed out and should be sent
+  // again. These take priority over `queued_probes_`.
+  std::deque<ProbeKey> queued_retransmits_;
+  int in_flight_probes_ = 0;
+  ProbeRtoEstimator rto_estimator_;
+
+  // Ping samples keyed by the token in their challenge.
+  std::unordered_map<uint32_t, PendingPing> pending_pings_;
+  // Tokens of `pending_pings_` that weren't sent yet, in FIFO order. These go
+  // out before `queued_probes_`, so that samples don't wait behind the scan.
+  std::deque<uint32_t> queued_pings_;
+  int in_flight_pings_ = 0;
+  uint32_t next_ping_token_ = 0;
+
+  Quake3ProbeSettings probe_settings_;
+  double probe_tokens_ = 0.0;
+  base::TimeTicks probe_tokens_refill_time_;
+
+  std::vector<std::unique_ptr<ActiveRefresh>> active_refreshes_;
+  int next_refresh_id_ = 0;
+  std::unordered_map<std::string, MasterAddress> master_addresses_;
+  ServerHealthMap server_health_;
+  // Servers of health-tracked probes completed since `server_health_` was
+  // last updated. Each probe counts once, however many refreshes shared it.
+  std::vector<quake3::ServerKey> replied_probe_servers_;
+  std::vector<quake3::ServerKey> timed_out_probe_servers_;
 
   base::WeakPtr<Quake3MasterBackendImpl> weak_this_;
   base::WeakPtrFactory<Quake3MasterBackendImpl> weak_factory_;
@@ -145,16 +1144,40 @@ Quake3MasterBackend::~Quake3MasterBackend() = default;
 
 Quake3MasterBackendImpl::Quake3MasterBackendImpl() : weak_factory_(this) {
   weak_this_ = weak_factory_.GetWeakPtr();
+  // Auto-reset, so a single wait consumes a single wakeup.
+  wakeup_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+  resolver_state_ = std::make_shared<MasterResolverState>();
+  resolver_state_->worker_wakeup_event = wakeup_event_;
   worker_thread_.Start();
-  worker_thread_.TaskRunner()->PostTask(
-      FROM_HERE,
+  io_thread_.Start();
+  PostTaskToWorker(
       base::BindOnce(&Quake3MasterBackendImpl::InitializeOnWorker, weak_this_));
 }
 
 Quake3MasterBackendImpl::~Quake3MasterBackendImpl() {
+  shutting_down_ = true;
+  SetEvent(wakeup_event_);
+  // Lookups still in flight are abandoned rather than waited for, as they may
+  // block for the whole DNS timeout. Resolvers post their results to the
+  // worker, so this has to happen before it's stopped.
+  {
+    std::lock_guard<std::mutex> lock(resolver_state_->mutex);
+    resolver_state_->abandoned = true;
+  }
   worker_thread_.Stop(
       FROM_HERE,
       base::BindOnce(&Quake3MasterBackendImpl::ShutdownOnWorker, weak_this_));
+  // Stopped after the worker, which posts to it, so that the last write
+  // completes.
+  io_thread_.Stop();
+  CloseHandle(wakeup_event_);
+}
+
+void Quake3MasterBackendImpl::PostTaskToWorker(base::OnceClosure task) {
+  worker_thread_.TaskRunner()->PostTask(FROM_HERE, std::move(task));
+  // The worker may be blocked waiting for socket readiness, so make sure it
+  // picks up the new task right away.
+  SetEvent(wakeup_event_);
 }
 
 void Quake3MasterBackendImpl::InitializeOnWorker() {
@@ -164,346 +1187,997 @@ void Quake3MasterBackendImpl::InitializeOnWorker() {
     return;
   }
 
-  sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  sock_ = CreateProbeSocket();
   if (sock_ == INVALID_SOCKET) {
     LOG(ERROR) << "Failed to create UDP socket: " << WSAGetLastError();
     return;
   }
 
-  u_long mode = 1;
-  ioctlsocket(sock_, FIONBIO, &mode);
+  UpdateReceiveBufferSizeOnWorker();
+  server_health_ = LoadServerHealth();
+
+  socket_event_ = WSACreateEvent();
+  if (socket_event_ == WSA_INVALID_EVENT ||
+      !receiver_.Initialize(sock_, socket_event_)) {
+    LOG(ERROR) << "Failed to start receiving on UDP socket: "
+               << WSAGetLastError();
+    closesocket(sock_);
+    sock_ = INVALID_SOCKET;
+    receiver_.Shutdown();
+    return;
+  }
 
   PollOnWorker();
 }
 
 void Quake3MasterBackendImpl::ShutdownOnWorker() {
+  shards_.clear();
   if (sock_ != INVALID_SOCKET) {
     closesocket(sock_);
     sock_ = INVALID_SOCKET;
   }
+  receiver_.Shutdown();
+  if (socket_event_ != WSA_INVALID_EVENT) {
+    WSACloseEvent(socket_event_);
+    socket_event_ = WSA_INVALID_EVENT;
+  }
   WSACleanup();
 }
 
+void Quake3MasterBackendImpl::SetProbeSettings(Quake3ProbeSettings settings) {
+  PostTaskToWorker(
+      base::BindOnce(&Quake3MasterBackendImpl::SetProbeSettingsOnWorker,
+                     weak_this_, settings));
+}
+
+void Quake3MasterBackendImpl::SetProbeSettingsOnWorker(
+    Quake3ProbeSettings settings) {
+  settings.probes_per_second = (std::max)(settings.probes_per_second, 1);
+  settings.max_in_flight_probes = (std::max)(settings.max_in_flight_probes, 1);
+  settings.receive_threads =
+      std::clamp(settings.receive_threads, 1, kMaxReceiveThreads);
+  settings.ping_samples = std::clamp(settings.ping_samples, 0, kMaxPingSamples);
+  probe_settings_ = settings;
+  UpdateReceiveShardsOnWorker();
+  UpdateReceiveBufferSizeOnWorker();
+}
+
+void Quake3MasterBackendImpl::UpdateReceiveBufferSizeOnWorker() {
+  if (sock_ == INVALID_SOCKET)
+    return;
+
+  // Every socket gets the full size, as the split of replies between them
+  // isn't exact.
+  const int buffer_size = std::clamp(
+      probe_settings_.max_in_flight_probes * kExpectedStatusResponseSize,
+      kMinReceiveBufferSize, kMaxReceiveBufferSize);
+  SetReceiveBufferSize(sock_, buffer_size);
+  for (const auto& shard : shards_)
+    SetReceiveBufferSize(shard->socket(), buffer_size);
+}
+
+void Quake3MasterBackendImpl::UpdateReceiveShardsOnWorker() {
+  const size_t shard_count =
+      static_cast<size_t>(probe_settings_.receive_threads - 1);
+  if (sock_ == INVALID_SOCKET || shards_.size() == shard_count)
+    return;
+
+  // Replies to in-flight probes and ping samples would be lost with their
+  // socket, so this is retried when the next refresh starts.
+  if (!pending_requests_.empty() || !pending_pings_.empty())
+    return;
+
+  shards_.clear();
+  const auto on_replies_callback = base::BindToCurrentSequence(
+      base::BindRepeating(&Quake3MasterBackendImpl::OnShardRepliesOnWorker,
+                          weak_this_),
+      FROM_HERE);
+  for (size_t idx = 0; idx < shard_count; ++idx) {
+    auto shard =
+        std::make_unique<ProbeReceiveShard>(on_replies_callback, wakeup_event_);
+    if (shard->socket() == INVALID_SOCKET)
+      break;
+    shards_.push_back(std::move(shard));
+  }
+}
+
 void Quake3MasterBackendImpl::SearchServers(
     const std::vector<std::string>& master_servers,
+    const Quake3MasterFilters& filters,
+    const std::vector<Quake3KnownServer>& known_servers,
+    base::RepeatingCallback<void(std::vector<Quake3ServerResult>)>
+        on_partial_results_callback,
     base::OnceCallback<void(Quake3MasterSearchResponse)> on_done_callback) {
-  worker_thread_.TaskRunner()->PostTask(
-      FROM_HERE,
-      base::BindOnce(&Quake3MasterBackendImpl::SearchServersOnWorker,
-                     weak_this_, master_servers, std::move(on_done_callback)));
+  PostTaskToWorker(base::BindOnce(
+      &Quake3MasterBackendImpl::SearchServersOnWorker, weak_this_,
+      master_servers, filters, known_servers,
+      std::move(on_partial_results_callback), std::move(on_done_callback)));
 }
 
 void Quake3MasterBackendImpl::SearchServersOnWorker(
     const std::vector<std::string> master_servers,
+    const Quake3MasterFilters& filters,
+    const std::vector<Quake3KnownServer>& known_servers,
+    base::RepeatingCallback<void(std::vector<Quake3ServerResult>)>
+        partial_results_callback,
     base::OnceCallback<void(Quake3MasterSearchResponse)> callback) {
-  if (active_refresh_) {
-    const auto kForce = true;
-    FinalizeRefreshIfReadyOnWorker(kForce);
-  }
-
-  active_refresh_ = std::make_unique<ActiveRefresh>();
-  active_refresh_->callback = std::move(callback);
-  active_refresh_->start_time = base::TimeTicks::Now();
-  active_refresh_->response.result.status = Result::Status::kOk;
-
-  // Drain any stale packets from the socket.
-  {
-    char trash[4096];
-    int from_len = sizeof(sockaddr_in);
-    sockaddr_in from{};
-    while (recvfrom(sock_, trash, sizeof(trash), 0, (sockaddr*)&from,
-                    &from_len) > 0) {
-    };
-  }
-
+  auto refresh = std::make_unique<ActiveRefresh>();
+  refresh->id = next_refresh_id_++;
+  refresh->callback = std::move(callback);
+  refresh->partial_results_callback = std::move(partial_results_callback);
+  refresh->start_time = base::TimeTicks::Now();
+  refresh->response.result.status = Result::Status::kOk;
+  refresh->query = probe_settings_.refresh_query;
+  refresh->master_requests = BuildGetServersRequests(filters);
+  if (active_refreshes_.empty())
+    rto_estimator_.Reset();
+  UpdateReceiveShardsOnWorker();
+
+  // Query masters with a cached address right away. The rest are queried as
+  // soon as their resolution completes.
+  const auto now = base::TimeTicks::Now();
   for (const auto& master : master_servers) {
-    size_t colon_pos = master.find(':');
-    std::string host =
-        (colon_pos != std::string::npos) ? master.substr(0, colon_pos) : master;
-    std::string port_str = (colon_pos != std::string::npos)
-                               ? master.substr(colon_pos + 1)
-                               : "27950";
-
-    struct addrinfo hints{}, *res;
-    hints.ai_family = AF_INET;
-    hints.ai_socktype = SOCK_DGRAM;
-
-    if (getaddrinfo(host.c_str(), port_str.c_str(), &hints, &res) != 0) {
-      LOG(WARNING) << "Failed to resolve master server: " << host;
+    auto it = master_addresses_.find(master);
+    if (it != master_addresses_.end() && !it->second.resolving &&
+        now < it->second.expiry_time) {
+      if (it->second.addr)
+        AddMasterToRefreshOnWorker(*refresh, *it->second.addr);
       continue;
     }
 
-    const char request[] = "\xff\xff\xff\xffgetservers 68";
-    sendto(sock_, request, sizeof(request) - 1, 0, res->ai_addr,
-           (int)res->ai_addrlen);
-
-    ActiveRefresh::MasterState state;
-    state.addr = *(sockaddr_in*)res->ai_addr;
-    active_refresh_->masters.push_back(state);
-
-    freeaddrinfo(res);
+    refresh->unresolved_masters.push_back(master);
+    ResolveMasterOnWorker(master);
   }
+  // Masters whose lookup failed recently are skipped, so if no other master
+  // is left the search is already over.
+  UpdateMasterSearchFinishedOnWorker(*refresh);
+
+  // Don't wait for masters (which are often slow or down) to start probing
+  // servers we already know about. Masters' replies are deduplicated against
+  // these through `seen_addresses`.
+  for (const auto& server : known_servers) {
+    const auto key =
+        quake3::ParseServerAddress(server.address, kDefaultServerPort);
+    if (!key)
+      continue;
+    if (server.ping_known && probe_settings_.ping_samples > 0)
+      refresh->known_ping_servers.insert(*key);
+    if (server.rtt_ms)
+      refresh->known_rtts_ms[*key] = *server.rtt_ms;
+    if (refresh->seen_addresses.insert(*key).second)
+      StartRefreshProbeOnWorker(*refresh, *key);
+  }
+
+  active_refreshes_.push_back(std::move(refresh));
 }
 
 void Quake3MasterBackendImpl::GetServerDetails(
     const std::string& server_address,
-    base::OnceCallback<void(base::net::ResourceResponse)> on_done_callback) {
-  worker_thread_.TaskRunner()->PostTask(
-      FROM_HERE,
+    base::OnceCallback<void(std::optional<Quake3ServerResult>)>
+        on_done_callback) {
+  PostTaskToWorker(
       base::BindOnce(&Quake3MasterBackendImpl::SendDetailsRequestOnWorker,
                      weak_this_, server_address, std::move(on_done_callback)));
 }
 
 void Quake3MasterBackendImpl::SendDetailsRequestOnWorker(
     std::string address,
-    base::OnceCallback<void(base::net::ResourceResponse)> callback) {
-  auto it = pending_requests_.find(address);
+    base::OnceCallback<void(std::optional<Quake3ServerResult>)> callback) {
+  const auto key = quake3::ParseServerAddress(address, kDefaultServerPort);
+  if (!key) {
+    LOG(WARNING) << "Invalid Quake 3 server address: " << address;
+    std::move(callback).Run(std::nullopt);
+    return;
+  }
+
+  StartProbeOnWorker(
+      *key, Quake3ServerQuery::kStatus, /*low_priority=*/false,
+      /*tracks_health=*/false, /*rtt_ms=*/std::nullopt,
+      base::BindOnce(
+          [](base::OnceCallback<void(std::optional<Quake3ServerResult>)>
+                 callback,
+             std::optional<Quake3ServerResult> server,
+             base::TimeDelta /*rtt*/) {
+            std::move(callback).Run(std::move(server));
+          },
+          std::move(callback)));
+}
+
+void Quake3MasterBackendImpl::StartProbeOnWorker(quake3::ServerKey key,
+                                                 Quake3ServerQuery query,
+                                                 bool low_priority,
+                                                 bool tracks_health,
+                                                 std::optional<int> rtt_ms,
+                                                 ProbeCallback callback) {
+  const auto probe_key = MakeProbeKey(key, query);
+  auto it = pending_requests_.find(probe_key);
   if (it != pending_requests_.end()) {
     it->second.callbacks.push_back(std::move(callback));
+    it->second.tracks_health |= tracks_health;
     return;
   }
 
-  size_t colon_pos = address.find(':');
-  std::string host =
-      (colon_pos != std::string::npos) ? address.substr(0, colon_pos) : address;
-  uint16_t port = (colon_pos != std::string::npos)
-                      ? (uint16_t)std::stoi(address.substr(colon_pos + 1))
-                      : 27960;
+  // The probe itself goes out from `FlushQueuedProbesOnWorker()` once the
+  // pacing allows it, which also sets the actual `start_time`.
+  PendingRequest pending;
+  pending.callbacks.push_back(std::move(callback));
+  pending.addr = ServerKeyToSockAddr(key);
+  pending.query = query;
+  pending.tracks_health = tracks_health;
 
-  sockaddr_in addr{};
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(port);
-  inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+  pending_requests_.emplace(probe_key, std::move(pending));
+  if (low_priority) {
+    queued_low_priority_probes_.push_back(probe_key);
+    return;
+  }
 
-  const char request[] = "\xff\xff\xff\xffgetstatus";
-  sendto(sock_, request, sizeof(request) - 1, 0, (sockaddr*)&addr,
-         sizeof(addr));
+  if (rtt_ms)
+    queued_ranked_probes_.emplace(*rtt_ms, probe_key);
+  else
+    queued_probes_.push_back(probe_key);
+}
 
-  PendingRequest pending;
-  pending.callbacks.push_back(std::move(callback));
-  pending.start_time = base::TimeTicks::Now();
-  pending.addr = addr;
+void Quake3MasterBackendImpl::FlushQueuedProbesOnWorker() {
+  RefillProbeTokensOnWorker(base::TimeTicks::Now());
+
+  // Retransmissions go first, as these probes are already in flight and
+  // their timeout is running.
+  while (!queued_retransmits_.empty() && probe_tokens_ >= 1.0) {
+    auto it = pending_requests_.find(queued_retransmits_.front());
+    queued_retransmits_.pop_front();
+    if (it == pending_requests_.end() || !it->second.retransmit_queued)
+      continue;
 
-  pending_requests_[address] = std::move(pending);
+    it->second.retransmit_queued = false;
+    it->second.retries++;
+    SendProbeOnWorker(it->second);
+  }
+
+  while (!queued_pings_.empty() && probe_tokens_ >= 1.0 &&
+         in_flight_probes_ + in_flight_pings_ <
+             probe_settings_.max_in_flight_probes) {
+    const uint32_t token = queued_pings_.front();
+    queued_pings_.pop_front();
+    auto it = pending_pings_.find(token);
+    if (it == pending_pings_.end())
+      continue;
+
+    SendPingSampleOnWorker(token, it->second);
+  }
+
+  while (probe_tokens_ >= 1.0 &&
+         in_flight_probes_ + in_flight_pings_ <
+             probe_settings_.max_in_flight_probes) {
+    const auto probe_key = PopQueuedProbeOnWorker();
+    if (!probe_key)
+      break;
+
+    auto it = pending_requests_.find(*probe_key);
+    if (it == pending_requests_.end() || it->second.sent)
+      continue;
+
+    it->second.start_time = base::TimeTicks::Now();
+    it->second.sent = true;
+    SendProbeOnWorker(it->second);
+    ++in_flight_probes_;
+  }
+}
+
+std::optional<ProbeKey> Quake3MasterBackendImpl::PopQueuedProbeOnWorker() {
+  const bool take_ranked =
+      !queued_ranked_probes_.empty() &&
+      (next_queued_probe_ranked_ || queued_probes_.empty());
+  if (take_ranked) {
+    const auto probe_key = queued_ranked_probes_.top().second;
+    queued_ranked_probes_.pop();
+    next_queued_probe_ranked_ = false;
+    return probe_key;
+  }
+  if (!queued_probes_.empty()) {
+    const auto probe_key = queued_probes_.front();
+    queued_probes_.pop_front();
+    next_queued_probe_ranked_ = true;
+    return probe_key;
+  }
+  if (!queued_low_priority_probes_.empty()) {
+    const auto probe_key = queued_low_priority_probes_.front();
+    queued_low_priority_probes_.pop_front();
+    return probe_key;
+  }
+  return std::nullopt;
+}
+
+void Quake3MasterBackendImpl::SendProbeOnWorker(PendingRequest& pending) {
+  const std::string_view request =
+      pending.query == Quake3ServerQuery::kInfo
+          ? std::string_view("\xff\xff\xff\xffgetinfo")
+          : std::string_view("\xff\xff\xff\xffgetstatus");
+
+  pending.last_send_time = base::TimeTicks::Now();
+  sendto(GetProbeSocketOnWorker(pending.addr), request.data(),
+         (int)request.size(), 0, (sockaddr*)&pending.addr,
+         sizeof(pending.addr));
+  probe_tokens_ -= 1.0;
+}
+
+void Quake3MasterBackendImpl::SendPingSampleOnWorker(uint32_t token,
+                                                     PendingPing& ping) {
+  const auto request = BuildPingRequest(token);
+  const auto addr = ServerKeyToSockAddr(ping.key);
+
+  ping.send_time = base::TimeTicks::Now();
+  sendto(GetProbeSocketOnWorker(addr), request.data(), (int)request.size(), 0,
+         (const sockaddr*)&addr, sizeof(addr));
+  probe_tokens_ -= 1.0;
+  ++in_flight_pings_;
+}
+
+SOCKET Quake3MasterBackendImpl::GetProbeSocketOnWorker(
+    const sockaddr_in& addr) const {
+  if (shards_.empty())
+    return sock_;
+
+  const size_t shard_idx =
+      GetShardIndex(SockAddrToServerKey(addr), shards_.size() + 1);
+  return shard_idx == 0 ? sock_ : shards_[shard_idx - 1]->socket();
+}
+
+void Quake3MasterBackendImpl::RefillProbeTokensOnWorker(base::TimeTicks now) {
+  const double rate = probe_settings_.probes_per_second;
+  const double capacity =
+      (std::max)(1.0, rate * kProbeBurstWindow.InMicroseconds() / 1000000.0);
+
+  if (probe_tokens_refill_time_.is_null()) {
+    probe_tokens_ = capacity;
+  } else {
+    const auto elapsed = now - probe_tokens_refill_time_;
+    probe_tokens_ = (std::min)(
+        capacity, probe_tokens_ + rate * elapsed.InMicroseconds() / 1000000.0);
+  }
+  probe_tokens_refill_time_ = now;
 }
 
 void Quake3MasterBackendImpl::PollOnWorker() {
-  if (sock_ == INVALID_SOCKET)
+  if (sock_ == INVALID_SOCKET || shutting_down_)
     return;
 
-  char buffer[16384];
-  sockaddr_in from{};
-  int from_len = sizeof(from);
-  int received;
+  ReceivePacketsOnWorker();
+  ProcessTimeoutsOnWorker();
+  DeliverPartialResultsOnWorker();
+  FlushQueuedProbesOnWorker();
 
-  while ((received = recvfrom(sock_, buffer, sizeof(buffer), 0,
-                              (sockaddr*)&from, &from_len)) > 0) {
-    DispatchPacketOnWorker(from, buffer, received);
+  if (!WaitForEventsOnWorker(GetNextDeadlineOnWorker())) {
+    worker_thread_.TaskRunner()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&Quake3MasterBackendImpl::PollOnWorker, weak_this_),
+        kPollRetryInterval);
+    return;
   }
 
+  // Re-post instead of looping so that tasks which woke us up (new searches,
+  // detail requests) get to run before we wait again.
+  worker_thread_.TaskRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&Quake3MasterBackendImpl::PollOnWorker, weak_this_));
+}
+
+void Quake3MasterBackendImpl::ReceivePacketsOnWorker() {
+  receiver_.ReceiveAll([this](const sockaddr_in& from,
+                              std::span<const std::byte> datagram,
+                              base::TimeTicks received_time) {
+    DispatchPacketOnWorker(from, datagram, received_time);
+  });
+}
+
+void Quake3MasterBackendImpl::ProcessTimeoutsOnWorker() {
   auto now = base::TimeTicks::Now();
 
-  if (active_refresh_ && !active_refresh_->master_search_finished &&
-      now - active_refresh_->start_time > kMasterSearchTimeout) {
-    active_refresh_->master_search_finished = true;
-    FinalizeRefreshIfReadyOnWorker();
+  for (auto& refresh : active_refreshes_) {
+    if (!refresh->master_search_finished &&
+        now - refresh->start_time >= kMasterSearchTimeout) {
+      refresh->master_search_finished = true;
+    }
   }
+  FinalizeRefreshesIfReadyOnWorker();
+
+  // Callbacks may start new probes, so they can only run after we're done
+  // iterating over `pending_requests_`.
+  std::vector<ProbeCallback> timed_out_callbacks;
 
   for (auto it = pending_requests_.begin(); it != pending_requests_.end();) {
-    if (now - it->second.start_time > kDetailTimeout) {
-      auto callbacks = std::move(it->second.callbacks);
-      for (auto& cb : callbacks) {
-        base::net::ResourceResponse response;
-        response.result = base::net::Result::kError;
-        std::move(cb).Run(std::move(response));
-      }
+    if (it->second.sent && now - it->second.start_time >= kDetailTimeout) {
+      if (it->second.tracks_health)
+        RecordProbeOutcomeOnWorker(it->first, /*replied=*/false);
+      for (auto& cb : it->second.callbacks)
+        timed_out_callbacks.push_back(std::move(cb));
       it = pending_requests_.erase(it);
+      --in_flight_probes_;
+      continue;
+    }
+
+    auto& pending = it->second;
+    if (pending.sent && !pending.retransmit_queued &&
+        pending.retries < kMaxProbeRetries &&
+        now - pending.last_send_time >=
+            rto_estimator_.GetRto(pending.retries)) {
+      pending.retransmit_queued = true;
+      queued_retransmits_.push_back(it->first);
+    }
+    ++it;
+  }
+
+  for (auto& cb : timed_out_callbacks) {
+    std::move(cb).Run(std::nullopt, base::TimeDelta());
+  }
+
+  std::vector<PendingPing> timed_out_pings;
+  for (auto it = pending_pings_.begin(); it != pending_pings_.end();) {
+    if (!it->second.send_time.is_null() &&
+        now - it->second.send_time >= kPingSampleTimeout) {
+      timed_out_pings.push_back(it->second);
+      it = pending_pings_.erase(it);
+      --in_flight_pings_;
     } else {
       ++it;
     }
   }
+  for (const auto& ping : timed_out_pings)
+    OnPingSampleOnWorker(ping.refresh_id, ping.key, std::nullopt);
+}
 
-  base::TimeDelta interval = (active_refresh_ || !pending_requests_.empty())
-                                 ? base::Milliseconds(1)
-                                 : base::Milliseconds(10);
+std::optional<base::TimeTicks>
+Quake3MasterBackendImpl::GetNextDeadlineOnWorker() const {
+  std::optional<base::TimeTicks> next_deadline;
+  auto update_deadline = [&next_deadline](base::TimeTicks deadline) {
+    if (!next_deadline || deadline < *next_deadline)
+      next_deadline = deadline;
+  };
 
-  worker_thread_.TaskRunner()->PostDelayedTask(
-      FROM_HERE,
-      base::BindOnce(&Quake3MasterBackendImpl::PollOnWorker, weak_this_),
-      interval);
-}
-
-void Quake3MasterBackendImpl::DispatchPacketOnWorker(const sockaddr_in& from,
-                                                     const char* buffer,
-                                                     int received) {
-  if (active_refresh_) {
-    for (auto& master : active_refresh_->masters) {
-      if (AreSockAddrEqual(from, master.addr)) {
-        std::string data(buffer, received);
-        size_t pos = data.find("getserversResponse");
-        if (pos != std::string::npos) {
-          pos += 18;
-          while (pos < (size_t)received) {
-            if (buffer[pos] == '\\' && pos + 7 <= (size_t)received) {
-              std::string host =
-                  std::to_string((unsigned char)buffer[pos + 1]) + "." +
-                  std::to_string((unsigned char)buffer[pos + 2]) + "." +
-                  std::to_string((unsigned char)buffer[pos + 3]) + "." +
-                  std::to_string((unsigned char)buffer[pos + 4]);
-              uint16_t port = ((unsigned char)buffer[pos + 5] << 8) |
-                              (unsigned char)buffer[pos + 6];
-
-              std::string addr_str = host + ":" + std::to_string(port);
-              if (active_refresh_->seen_addresses.insert(addr_str).second) {
-                // NEW SERVER FOUND: Start detail query immediately!
-                active_refresh_->pending_details_count++;
-                SendDetailsRequestOnWorker(
-                    addr_str,
-                    base::BindOnce(
-                        &Quake3MasterBackendImpl::OnInternalDetailResponse,
-                        weak_this_, addr_str));
-              }
-              pos += 7;
-            } else if (buffer[pos] == 'E' && pos + 2 < (size_t)received &&
-                       buffer[pos + 1] == 'O' && buffer[pos + 2] == 'T') {
-              master.got_eot = true;
-              break;
-            } else {
-              pos++;
-            }
-          }
-
-          bool all_finished = true;
-          for (const auto& m : active_refresh_->masters) {
-            if (!m.got_eot) {
-              all_finished = false;
-              break;
-            }
-          }
-          if (all_finished) {
-            active_refresh_->master_search_finished = true;
-            FinalizeRefreshIfReadyOnWorker();
-          }
+  for (const auto& refresh : active_refreshes_) {
+    if (!refresh->master_search_finished) {
+      update_deadline(refresh->start_time + kMasterSearchTimeout);
+    } else if (!refresh->finalized && !refresh->pending_servers.empty() &&
+               refresh->reply_rtts_us.size() >= kMinTailSamples) {
+      update_deadline(refresh->next_tail_check_time);
+    }
+    if (refresh->partial_results_callback &&
+        refresh->delivered_servers_count < refresh->response.servers.size()) {
+      update_deadline(refresh->last_partial_delivery_time +
+                      kPartialResultsInterval);
+    }
+  }
+  for (const auto& [key, pending] : pending_requests_) {
+    if (!pending.sent)
+      continue;
+    update_deadline(pending.start_time + kDetailTimeout);
+    if (!pending.retransmit_queued && pending.retries < kMaxProbeRetries) {
+      update_deadline(pending.last_send_time +
+                      rto_estimator_.GetRto(pending.retries));
+    }
+  }
+
+  for (const auto& [token, ping] : pending_pings_) {
+    if (!ping.send_time.is_null())
+      update_deadline(ping.send_time + kPingSampleTimeout);
+  }
+
+  // Wake up when the next probe can be sent, unless we're waiting for
+  // in-flight probes to complete first.
+  const bool can_send_more = in_flight_probes_ + in_flight_pings_ <
+                             probe_settings_.max_in_flight_probes;
+  if (!queued_retransmits_.empty() ||
+      (can_send_more &&
+       (!queued_pings_.empty() || !queued_ranked_probes_.empty() ||
+        !queued_probes_.empty() || !queued_low_priority_probes_.empty()))) {
+    const double missing_tokens = (std::max)(0.0, 1.0 - probe_tokens_);
+    update_deadline(probe_tokens_refill_time_ +
+                    base::Microseconds(static_cast<int64_t>(
+                        missing_tokens * 1000000.0 /
+                        probe_settings_.probes_per_second)));
+  }
+
+  return next_deadline;
+}
+
+bool Quake3MasterBackendImpl::WaitForEventsOnWorker(
+    std::optional<base::TimeTicks> deadline) {
+  DWORD timeout_ms = WSA_INFINITE;
+  if (deadline) {
+    const auto remaining = *deadline - base::TimeTicks::Now();
+    // Round up so that we never wake up right before the deadline and spin.
+    timeout_ms = static_cast<DWORD>(
+        (std::max)(int64_t{0}, remaining.InMilliseconds() + 1));
+  }
+
+  const WSAEVENT events[] = {socket_event_, wakeup_event_};
+  const DWORD result = WSAWaitForMultipleEvents(
+      static_cast<DWORD>(std::size(events)), events, FALSE, timeout_ms, FALSE);
+  if (result == WSA_WAIT_FAILED) {
+    LOG(ERROR) << "Failed to wait for UDP socket events: "
+               << WSAGetLastError();
+    return false;
+  }
+  return true;
+}
+
+void Quake3MasterBackendImpl::DispatchPacketOnWorker(
+    const sockaddr_in& from,
+    std::span<const std::byte> datagram,
+    base::TimeTicks received_time) {
+  const auto from_key = SockAddrToServerKey(from);
+
+  // The same master may be queried by multiple refreshes, so its response is
+  // parsed once and passed to all of them.
+  bool from_master = false;
+  for (auto& refresh : active_refreshes_) {
+    for (auto& master : refresh->masters) {
+      if (master.key != from_key)
+        continue;
+      if (!from_master) {
+        from_master = true;
+        if (!quake3::ParseGetServersResponse(datagram,
+                                             &parsed_master_response_)) {
+          return;
         }
-        return;
       }
+      if (!master.got_eot && !refresh->master_search_finished)
+        OnMasterResponseOnWorker(*refresh, master, parsed_master_response_);
     }
   }
+  if (from_master) {
+    FinalizeRefreshesIfReadyOnWorker();
+    return;
+  }
 
-  std::string addr_str = SockAddrToString(from);
-  auto it = pending_requests_.find(addr_str);
-  if (it != pending_requests_.end()) {
-    base::TimeDelta timing = base::TimeTicks::Now() - it->second.start_time;
-    auto callbacks = std::move(it->second.callbacks);
-    pending_requests_.erase(it);
-
-    for (auto& cb : callbacks) {
-      base::net::ResourceResponse response;
-      response.result = base::net::Result::kOk;
-      response.data.assign(buffer, buffer + received);
-      response.timing_connect = timing;
-      response.timing_queue = base::Seconds(0);
-      std::move(cb).Run(std::move(response));
+  DispatchProbeReplyOnWorker(ParseProbeReply(from_key, datagram, received_time,
+                                             &parsed_server_response_));
+}
+
+void Quake3MasterBackendImpl::OnShardRepliesOnWorker(
+    std::vector<ProbeReply> replies) {
+  for (auto& reply : replies)
+    DispatchProbeReplyOnWorker(std::move(reply));
+}
+
+void Quake3MasterBackendImpl::DispatchProbeReplyOnWorker(ProbeReply reply) {
+  if (reply.ping_token) {
+    auto it = pending_pings_.find(*reply.ping_token);
+    if (it == pending_pings_.end() || it->second.key != reply.from ||
+        it->second.send_time.is_null()) {
+      return;
+    }
+
+    const auto ping = it->second;
+    pending_pings_.erase(it);
+    --in_flight_pings_;
+    OnPingSampleOnWorker(ping.refresh_id, ping.key,
+                         reply.received_time - ping.send_time);
+    return;
+  }
+
+  auto it = pending_requests_.find(MakeProbeKey(reply.from, reply.query));
+  if (it == pending_requests_.end() || !it->second.sent)
+    return;
+
+  // A reply to a retransmitted probe may still answer an earlier send, so
+  // only unambiguous samples feed the RTO estimator (Karn's algorithm).
+  reply.rtt = reply.received_time - it->second.last_send_time;
+  if (it->second.retries == 0)
+    rto_estimator_.AddSample(reply.rtt);
+  if (it->second.tracks_health)
+    RecordProbeOutcomeOnWorker(it->first, reply.server.has_value());
+  auto callbacks = std::move(it->second.callbacks);
+  pending_requests_.erase(it);
+  --in_flight_probes_;
+
+  if (reply.server)
+    reply.server->ping = (int)reply.rtt.InMilliseconds();
+  for (auto& cb : callbacks)
+    std::move(cb).Run(reply.server, reply.rtt);
+}
+
+void Quake3MasterBackendImpl::ResolveMasterOnWorker(const std::string& master) {
+  auto& entry = master_addresses_[master];
+  if (entry.resolving)
+    return;
+  entry.resolving = true;
+
+  // Lookups are rare thanks to the address cache, so each gets its own thread.
+  // It's detached so that shutdown doesn't wait for a stuck `getaddrinfo()`.
+  std::thread(&ResolveMasterOnResolverThread, master,
+              base::BindToCurrentSequence(
+                  base::BindOnce(
+                      &Quake3MasterBackendImpl::OnMasterResolvedOnWorker,
+                      weak_this_, master),
+                  FROM_HERE),
+              resolver_state_)
+      .detach();
+}
+
+void Quake3MasterBackendImpl::OnMasterResolvedOnWorker(
+    std::string master,
+    std::optional<sockaddr_in> addr) {
+  if (!addr)
+    LOG(WARNING) << "Failed to resolve master server: " << master;
+
+  auto& entry = master_addresses_[master];
+  entry.addr = addr;
+  entry.expiry_time = base::TimeTicks::Now() +
+                      (addr ? kMasterAddressTtl : kFailedMasterAddressTtl);
+  entry.resolving = false;
+
+  for (auto& refresh : active_refreshes_) {
+    if (std::erase(refresh->unresolved_masters, master) == 0 ||
+        refresh->master_search_finished) {
+      continue;
+    }
+
+    if (addr)
+      AddMasterToRefreshOnWorker(*refresh, *addr);
+    else
+      UpdateMasterSearchFinishedOnWorker(*refresh);
+  }
+  FinalizeRefreshesIfReadyOnWorker();
+}
+
+void Quake3MasterBackendImpl::AddMasterToRefreshOnWorker(
+    ActiveRefresh& refresh,
+    const sockaddr_in& addr) {
+  ActiveRefresh::MasterState state;
+  state.addr = addr;
+  state.key = SockAddrToServerKey(state.addr);
+
+  // Join a query of this master that another refresh is still waiting for,
+  // instead of sending another one.
+  if (const auto* in_progress = FindMasterQueryInProgressOnWorker(
+          state.key, refresh.master_requests)) {
+    state.servers = in_progress->servers;
+    state.pending_responses = in_progress->pending_responses;
+  } else {
+    for (const auto& request : refresh.master_requests) {
+      sendto(sock_, request.data(), (int)request.size(), 0,
+             (const sockaddr*)&state.addr, sizeof(state.addr));
+    }
+    state.pending_responses = static_cast<int>(refresh.master_requests.size());
+  }
+
+  for (const auto key : state.servers) {
+    if (refresh.seen_addresses.insert(key).second)
+      StartRefreshProbeOnWorker(refresh, key);
+  }
+  refresh.masters.push_back(std::move(state));
+}
+
+void Quake3MasterBackendImpl::UpdateMasterSearchFinishedOnWorker(
+    ActiveRefresh& refresh) {
+  if (!refresh.unresolved_masters.empty())
+    return;
+  for (const auto& master : refresh.masters) {
+    if (!master.got_eot)
+      return;
+  }
+  refresh.master_search_finished = true;
+}
+
+void Quake3MasterBackendImpl::OnMasterResponseOnWorker(
+    ActiveRefresh& refresh,
+    ActiveRefresh::MasterState& master,
+    const quake3::GetServersResponse& response) {
+  for (const auto key : response.servers) {
+    master.servers.push_back(key);
+    if (refresh.seen_addresses.insert(key).second) {
+      // NEW SERVER FOUND: Start detail query immediately!
+      StartRefreshProbeOnWorker(refresh, key);
+    }
+  }
+
+  if (response.end_of_transmission && --master.pending_responses <= 0) {
+    master.got_eot = true;
+    UpdateMasterSearchFinishedOnWorker(refresh);
+  }
+}
+
+const Quake3MasterBackendImpl::ActiveRefresh::MasterState*
+Quake3MasterBackendImpl::FindMasterQueryInProgressOnWorker(
+    quake3::ServerKey key,
+    const std::vector<std::string>& requests) const {
+  for (const auto& refresh : active_refreshes_) {
+    if (refresh->master_search_finished || refresh->master_requests != requests)
+      continue;
+    for (const auto& master : refresh->masters) {
+      if (master.key == key && !master.got_eot)
+        return &master;
     }
   }
+  return nullptr;
+}
+
+Quake3MasterBackendImpl::ActiveRefresh*
+Quake3MasterBackendImpl::FindRefreshOnWorker(int refresh_id) {
+  for (auto& refresh : active_refreshes_) {
+    if (refresh->id == refresh_id)
+      return refresh.get();
+  }
+  return nullptr;
+}
+
+void Quake3MasterBackendImpl::StartRefreshProbeOnWorker(
+    ActiveRefresh& refresh,
+    quake3::ServerKey key) {
+  auto health = server_health_.find(key);
+  if (health != server_health_.end() &&
+      ShouldSkipDeadServer(health->second, GetUnixTimeSeconds())) {
+    refresh.skipped_probes_count++;
+    return;
+  }
+
+  // Joins the probe if another refresh already has one pending for `key`.
+  refresh.pending_servers.insert(key);
+  const auto known_rtt = refresh.known_rtts_ms.find(key);
+  StartProbeOnWorker(
+      key, refresh.query,
+      /*low_priority=*/health != server_health_.end() &&
+          health->second.consecutive_timeouts > 0,
+      /*tracks_health=*/true,
+      known_rtt != refresh.known_rtts_ms.end()
+          ? std::optional<int>(known_rtt->second)
+          : std::nullopt,
+      base::BindOnce(&Quake3MasterBackendImpl::OnInternalDetailResponse,
+                     weak_this_, refresh.id, key));
 }
 
 void Quake3MasterBackendImpl::OnInternalDetailResponse(
-    std::string address,
-    base::net::ResourceResponse response) {
-  if (!active_refresh_)
+    int refresh_id,
+    quake3::ServerKey server_key,
+    std::optional<Quake3ServerResult> server,
+    base::TimeDelta rtt) {
+  auto* refresh = FindRefreshOnWorker(refresh_id);
+  if (!refresh)
     return;
 
-  if (response.result == base::net::Result::kOk) {
-    std::string data = response.DataAsString();
-    size_t header_pos = data.find("statusResponse\n");
-    if (header_pos != std::string::npos) {
-      std::string content = data.substr(header_pos + 15);
-      size_t player_list_pos = content.find('\n');
-
-      std::string cvar_block = content.substr(0, player_list_pos);
-      if (!cvar_block.empty() && cvar_block[0] == '\\')
-        cvar_block = cvar_block.substr(1);
-
-      std::map<std::string, std::string> cvars;
-      std::stringstream ss(cvar_block);
-      std::string key, val;
-      while (std::getline(ss, key, '\\') && std::getline(ss, val, '\\')) {
-        if (!key.empty())
-          cvars[key] = val;
-      }
+  if (server) {
+    refresh->reply_rtts_us.push_back(rtt.InMicroseconds());
+    refresh->reply_rtts_sorted = false;
+    if (probe_settings_.ping_samples > 0 && !refresh->finalized &&
+        !refresh->known_ping_servers.contains(server_key)) {
+      refresh->pinging_servers[server_key] = ActiveRefresh::PingState{
+          std::move(*server), {}, probe_settings_.ping_samples};
+      QueuePingSampleOnWorker(refresh_id, server_key);
+    } else {
+      refresh->response.servers.push_back(std::move(*server));
+    }
+  } else {
+    refresh->failed_probes_count++;
+  }
 
-      int player_count = 0;
-      std::vector<Quake3ServerResult::Member> members;
-      if (player_list_pos != std::string::npos) {
-        std::string player_list = content.substr(player_list_pos + 1);
-        std::stringstream pss(player_list);
-        std::string player_line;
-        while (std::getline(pss, player_line)) {
-          if (player_line.empty())
-            continue;
-
-          std::stringstream lss(player_line);
-          int score, ping;
-          std::string name;
-          if (lss >> score >> ping) {
-            std::getline(lss, name);
-            // Remove quotes and leading spaces
-            size_t first = name.find_first_not_of(" ");
-            if (first != std::string::npos)
-              name = name.substr(first);
-            if (name.size() >= 2 && name.front() == '"' && name.back() == '"') {
-              name = name.substr(1, name.size() - 2);
-            }
-
-            members.push_back({score, ping, CleanQuake3String(name)});
-            player_count++;
-          }
-        }
-      }
+  refresh->pending_servers.erase(server_key);
+  FinalizeRefreshesIfReadyOnWorker();
+}
 
-      Quake3ServerResult result;
-      result.address = address;
-      result.hostname = CleanQuake3String(cvars["sv_hostname"]);
-      if (result.hostname.empty())
-        result.hostname = cvars["sv_hostname"];
-      if (result.hostname.empty())
-        result.hostname = "Unnamed Server";
-
-      result.map = CleanQuake3String(cvars["mapname"]);
-      if (result.map.empty())
-        result.map = cvars["mapname"];
-      if (result.map.empty())
-        result.map = "Unknown Map";
-
-      try {
-        result.max_players = std::stoi(cvars["sv_maxclients"]);
-      } catch (...) {
-      }
-      result.players = player_count;
-      result.game_type = MapGameType(cvars["g_gametype"]);
-      result.ping = (int)response.timing_connect.InMilliseconds();
-      result.metadata = std::move(cvars);
-      result.members = std::move(members);
+void Quake3MasterBackendImpl::QueuePingSampleOnWorker(int refresh_id,
+                                                      quake3::ServerKey key) {
+  const uint32_t token = next_ping_token_++;
+  pending_pings_.emplace(token, PendingPing{refresh_id, key, {}});
+  queued_pings_.push_back(token);
+}
+
+void Quake3MasterBackendImpl::OnPingSampleOnWorker(
+    int refresh_id,
+    quake3::ServerKey key,
+    std::optional<base::TimeDelta> rtt) {
+  auto* refresh = FindRefreshOnWorker(refresh_id);
+  if (!refresh)
+    return;
+  auto it = refresh->pinging_servers.find(key);
+  if (it == refresh->pinging_servers.end())
+    return;
+
+  auto& state = it->second;
+  if (rtt)
+    state.rtts_us.push_back(rtt->InMicroseconds());
+
+  // Samples are sent one after another, so that they don't queue up behind
+  // each other.
+  if (--state.remaining_samples > 0) {
+    QueuePingSampleOnWorker(refresh_id, key);
+    return;
+  }
+
+  refresh->response.servers.push_back(TakeSampledServer(state));
+  refresh->pinging_servers.erase(it);
+  FinalizeRefreshesIfReadyOnWorker();
+}
+
+// static
+Quake3ServerResult Quake3MasterBackendImpl::TakeSampledServer(
+    ActiveRefresh::PingState& state) {
+  // If all samples were lost, the server keeps the ping of its probe.
+  auto& server = state.server;
+  if (!state.rtts_us.empty()) {
+    // Jitter is the mean absolute difference between consecutive samples,
+    // so it's computed before sorting. Unlike the smoothed estimator of
+    // RFC 3550 (with a gain of 1/16), this doesn't need many samples to
+    // settle.
+    int64_t jitter_us = 0;
+    for (size_t idx = 1; idx < state.rtts_us.size(); ++idx)
+      jitter_us += std::abs(state.rtts_us[idx] - state.rtts_us[idx - 1]);
+    if (state.rtts_us.size() > 1)
+      jitter_us /= static_cast<int64_t>(state.rtts_us.size() - 1);
+
+    std::sort(state.rtts_us.begin(), state.rtts_us.end());
+    server.ping = static_cast<int>(
+        base::Microseconds(state.rtts_us[state.rtts_us.size() / 2])
+            .InMilliseconds());
+    server.min_ping = static_cast<int>(
+        base::Microseconds(state.rtts_us.front()).InMilliseconds());
+    server.ping_jitter =
+        static_cast<int>(base::Microseconds(jitter_us).InMilliseconds());
+  }
+  return std::move(server);
+}
+
+void Quake3MasterBackendImpl::DeliverPartialResultsOnWorker() {
+  const auto now = base::TimeTicks::Now();
+  bool delivered_late_replies = false;
+
+  for (auto& refresh : active_refreshes_) {
+    if (!refresh->partial_results_callback)
+      continue;
 
-      active_refresh_->response.servers.push_back(std::move(result));
+    const auto& servers = refresh->response.servers;
+    if (refresh->delivered_servers_count == servers.size())
+      continue;
+
+    // The first batch goes out right away, so that the UI isn't empty while
+    // waiting for the slowest servers.
+    if (refresh->delivered_servers_count > 0 &&
+        now - refresh->last_partial_delivery_time < kPartialResultsInterval) {
+      continue;
+    }
+
+    std::vector<Quake3ServerResult> batch(
+        servers.begin() + refresh->delivered_servers_count, servers.end());
+    refresh->delivered_servers_count = servers.size();
+    refresh->last_partial_delivery_time = now;
+    refresh->partial_results_callback.Run(std::move(batch));
+    delivered_late_replies |= refresh->finalized;
+  }
+
+  // Finalized refreshes may be waiting only for these to be delivered.
+  if (delivered_late_replies)
+    FinalizeRefreshesIfReadyOnWorker();
+}
+
+bool Quake3MasterBackendImpl::IsInRefreshTailOnWorker(ActiveRefresh& refresh,
+                                                      base::TimeTicks now) {
+  if (refresh.reply_rtts_us.size() < kMinTailSamples ||
+      now < refresh.next_tail_check_time) {
+    return false;
+  }
+  refresh.next_tail_check_time = now + kTailCheckInterval;
+
+  auto& rtts = refresh.reply_rtts_us;
+  if (!refresh.reply_rtts_sorted) {
+    std::sort(rtts.begin(), rtts.end());
+    refresh.reply_rtts_sorted = true;
+  }
+  const int64_t p99_rtt_us = rtts[(rtts.size() - 1) * 99 / 100];
+
+  // Smoothed, so that it never reaches 0 or 1.
+  const double reply_ratio =
+      (rtts.size() + 1.0) / (rtts.size() + refresh.failed_probes_count + 2.0);
+
+  // Sum of probabilities that each pending probe still gets a reply, given
+  // that it didn't get one for as long as it's been waiting. Replies so far
+  // show how likely a reply is to take that long.
+  double expected_late_replies = 0.0;
+  bool past_p99_deadline = true;
+  for (const auto key : refresh.pending_servers) {
+    auto it = pending_requests_.find(MakeProbeKey(key, refresh.query));
+    if (it == pending_requests_.end() || !it->second.sent)
+      return false;
+
+    const int64_t waiting_us = (now - it->second.start_time).InMicroseconds();
+    if (waiting_us < p99_rtt_us * kTailDeadlineFactor)
+      past_p99_deadline = false;
+
+    const auto slower_replies =
+        rtts.end() - std::upper_bound(rtts.begin(), rtts.end(), waiting_us);
+    const double late_reply_probability =
+        reply_ratio * slower_replies / static_cast<double>(rtts.size());
+    expected_late_replies += late_reply_probability /
+                             (late_reply_probability + (1.0 - reply_ratio));
+  }
+
+  return past_p99_deadline || expected_late_replies < kMaxExpectedLateReplies;
+}
+
+void Quake3MasterBackendImpl::FinalizeRefreshesIfReadyOnWorker() {
+  const auto now = base::TimeTicks::Now();
+
+  // Callbacks run only after `active_refreshes_` is updated, in case they
+  // start new refreshes.
+  std::vector<std::pair<base::OnceCallback<void(Quake3MasterSearchResponse)>,
+                        Quake3MasterSearchResponse>>
+      finished_refreshes;
+
+  for (auto it = active_refreshes_.begin(); it != active_refreshes_.end();) {
+    auto& refresh = **it;
+    if (!refresh.finalized && refresh.master_search_finished &&
+        (refresh.pending_servers.empty()
+             ? refresh.pinging_servers.empty()
+             : IsInRefreshTailOnWorker(refresh, now))) {
+      refresh.finalized = true;
+      // Ping sampling doesn't hold back the early finalization, so servers
+      // still being sampled go out with the samples they got so far. Their
+      // remaining samples are dropped by `OnPingSampleOnWorker()`.
+      for (auto& [key, state] : refresh.pinging_servers)
+        refresh.response.servers.push_back(TakeSampledServer(state));
+      refresh.pinging_servers.clear();
+      refresh.response.skipped_probes = refresh.skipped_probes_count;
+      LOG(INFO) << "Quake 3 refresh skipped " << refresh.skipped_probes_count
+                << " probes of unresponsive servers";
+      finished_refreshes.emplace_back(std::move(refresh.callback),
+                                      std::move(refresh.response));
+      refresh.response = {};
+      refresh.delivered_servers_count = 0;
+    }
+
+    // Finalized refreshes are kept around until all their probes complete
+    // and late replies are delivered.
+    if (refresh.finalized && refresh.pending_servers.empty() &&
+        refresh.pinging_servers.empty() &&
+        (!refresh.partial_results_callback ||
+         refresh.delivered_servers_count == refresh.response.servers.size())) {
+      UpdateServerHealthOnWorker();
+      it = active_refreshes_.erase(it);
+    } else {
+      ++it;
     }
   }
 
-  active_refresh_->pending_details_count--;
-  FinalizeRefreshIfReadyOnWorker();
+  for (auto& [callback, response] : finished_refreshes) {
+    std::move(callback).Run(std::move(response));
+  }
+}
+
+void Quake3MasterBackendImpl::RecordProbeOutcomeOnWorker(ProbeKey probe_key,
+                                                         bool replied) {
+  const quake3::ServerKey key = GetProbeServerKey(probe_key);
+  if (replied)
+    replied_probe_servers_.push_back(key);
+  else
+    timed_out_probe_servers_.push_back(key);
 }
 
-void Quake3MasterBackendImpl::FinalizeRefreshIfReadyOnWorker(bool force) {
-  if (!active_refresh_)
+void Quake3MasterBackendImpl::UpdateServerHealthOnWorker() {
+  // Timeouts say nothing about servers if nothing replied, e.g. when we were
+  // offline.
+  if (replied_probe_servers_.empty()) {
+    timed_out_probe_servers_.clear();
     return;
-  if ((active_refresh_->master_search_finished &&
-       active_refresh_->pending_details_count <= 0) ||
-      force) {
-    std::move(active_refresh_->callback)
-        .Run(std::move(active_refresh_->response));
-    active_refresh_.reset();
   }
+
+  const int64_t now = GetUnixTimeSeconds();
+  for (const auto key : replied_probe_servers_) {
+    auto& health = server_health_[key];
+    health.consecutive_timeouts = 0;
+    health.last_success_time = now;
+    health.last_probe_time = now;
+  }
+  for (const auto key : timed_out_probe_servers_) {
+    auto& health = server_health_[key];
+    health.consecutive_timeouts++;
+    health.last_probe_time = now;
+  }
+  replied_probe_servers_.clear();
+  timed_out_probe_servers_.clear();
+
+  std::erase_if(server_health_, [now](const auto& entry) {
+    return now - entry.second.last_probe_time > kServerHealthMaxAgeSeconds;
+  });
+  io_thread_.TaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&SaveServerHealth, server_health_));
 }
 
 }  // namespace engine::backend
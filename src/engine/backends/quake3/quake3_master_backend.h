@@ -2,6 +2,7 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
 #include <vector>
@@ -28,14 +29,72 @@ struct Quake3ServerResult {
   int players = 0;
   int max_players = 0;
   std::string game_type;
+  // Median of ping samples, if these were taken. Otherwise round trip time of
+  // the query.
   int ping = 0;
+  // Set only if ping samples were taken.
+  std::optional<int> min_ping;
+  std::optional<int> ping_jitter;
+  // Unknown for `getinfo` results from servers which don't report it.
+  std::optional<int> humans;
   std::map<std::string, std::string> metadata;
+  // False for `getinfo` results, which don't list players.
+  bool has_members = true;
   std::vector<Member> members;
 };
 
 struct Quake3MasterSearchResponse {
   Result result;
   std::vector<Quake3ServerResult> servers;
+  // Probes not sent to servers which didn't reply to recent refreshes.
+  int skipped_probes = 0;
+};
+
+// Filters applied by master servers, so that servers which would be filtered
+// out anyway aren't probed. Masters which don't support some of these return
+// more servers than requested.
+struct Quake3MasterFilters {
+  // Empty for all game types.
+  std::vector<int> game_types;
+  bool include_empty = true;
+  bool include_full = true;
+};
+
+// Server the caller already knows about, e.g. from the previous refresh. These
+// are probed right away, without waiting for master servers to list them.
+struct Quake3KnownServer {
+  // IP:Port.
+  std::string address;
+  // Set if the server's ping was measured recently, so it isn't sent ping
+  // samples.
+  bool ping_known = false;
+  // Caller's estimate of the server's round trip time, if it has one. Nearby
+  // servers are probed first.
+  std::optional<int> rtt_ms;
+};
+
+enum class Quake3ServerQuery {
+  // `getstatus` - all cvars and the player list.
+  kStatus,
+  // `getinfo` - only basic info needed for listing, a fraction of the size.
+  kInfo,
+};
+
+// Limits how fast server probes are sent out during a refresh, so that
+// replies aren't dropped by the local receive buffer or home routers.
+struct Quake3ProbeSettings {
+  int probes_per_second = 500;
+  int max_in_flight_probes = 250;
+  // Query sent to every server during a refresh. Details of a single server
+  // are always queried with `getstatus`.
+  Quake3ServerQuery refresh_query = Quake3ServerQuery::kStatus;
+  // Number of sockets, each with its own thread, that replies are received
+  // and parsed on. Helps only with very large (10k+ servers) refreshes.
+  int receive_threads = 1;
+  // Number of extra `getinfo` queries sent to each server that replied during
+  // a refresh, to measure its ping without the noise of the bulk scan.
+  // 0 disables these.
+  int ping_samples = 0;
 };
 
 class Quake3MasterBackend {
@@ -45,14 +104,27 @@ class Quake3MasterBackend {
   Quake3MasterBackend();
   virtual ~Quake3MasterBackend();
 
+  // `on_partial_results_callback` (optional) is periodically called with
+  // batches of servers found since its previous call. The final response
+  // still contains all servers found so far. It may come before the slowest
+  // servers reply, once these are unlikely to, in which case late replies are
+  // passed only to `on_partial_results_callback`.
   virtual void SearchServers(
       const std::vector<std::string>& master_servers,
+      const Quake3MasterFilters& filters,
+      const std::vector<Quake3KnownServer>& known_servers,
+      base::RepeatingCallback<void(std::vector<Quake3ServerResult>)>
+          on_partial_results_callback,
       base::OnceCallback<void(Quake3MasterSearchResponse)>
           on_done_callback) = 0;
 
+  virtual void SetProbeSettings(Quake3ProbeSettings settings) = 0;
+
+  // Queries full status, including players, of a single server. Runs
+  // `on_done_callback` with nothing if the server didn't reply.
   virtual void GetServerDetails(
       const std::string& server_address,
-      base::OnceCallback<void(base::net::ResourceResponse)>
+      base::OnceCallback<void(std::optional<Quake3ServerResult>)>
           on_done_callback) = 0;
 };
 
@@ -0,0 +1,69 @@
+#include "engine/backends/rtt/rtt_cache.h"
+
+#include <cstdint>
+#include <iterator>
+
+namespace engine::backend {
+
+namespace {
+
+// Weight of the previous estimate in `Entry::smoothed_rtt`, out of 4.
+constexpr int64_t kRttEstimateWeight = 3;
+
+// Stale entries are still shown until the server is measured again, so these
+// are only dropped once the server was gone for much longer than the TTL.
+constexpr int kEntryLifetimeInTtls = 12;
+
+}  // namespace
+
+RttCache::RttCache(base::TimeDelta ttl) : ttl_(ttl) {}
+
+RttCache::~RttCache() = default;
+
+std::optional<base::TimeDelta> RttCache::Get(
+    const std::string& address) const {
+  auto it = entries_.find(address);
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  return it->second.smoothed_rtt;
+}
+
+bool RttCache::IsFresh(const std::string& address) const {
+  auto it = entries_.find(address);
+  return it != entries_.end() &&
+         base::TimeTicks::Now() - it->second.update_time < ttl_;
+}
+
+base::TimeDelta RttCache::AddSample(const std::string& address,
+                                    base::TimeDelta rtt) {
+  const auto now = base::TimeTicks::Now();
+  PruneExpiredEntries(now);
+
+  auto [it, inserted] = entries_.try_emplace(address, Entry{rtt, now});
+  if (!inserted) {
+    auto& entry = it->second;
+    entry.smoothed_rtt = base::Microseconds(
+        (entry.smoothed_rtt.InMicroseconds() * kRttEstimateWeight +
+         rtt.InMicroseconds() * (4 - kRttEstimateWeight)) /
+        4);
+    entry.update_time = now;
+  }
+  return it->second.smoothed_rtt;
+}
+
+void RttCache::PruneExpiredEntries(base::TimeTicks now) {
+  const auto lifetime =
+      base::Microseconds(ttl_.InMicroseconds() * kEntryLifetimeInTtls);
+  if (now - last_prune_time_ < lifetime) {
+    return;
+  }
+  last_prune_time_ = now;
+
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    it = (now - it->second.update_time >= lifetime) ? entries_.erase(it)
+                                                    : std::next(it);
+  }
+}
+
+}  // namespace engine::backend
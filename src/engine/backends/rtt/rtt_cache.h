@@ -0,0 +1,52 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "base/time/time_delta.h"
+#include "base/time/time_ticks.h"
+
+namespace engine::backend {
+
+// Remembers round trip times to servers across searches, so that repeated
+// refreshes only need to probe servers that weren't measured recently.
+// Samples are smoothed with an exponentially weighted moving average, so a
+// single slow reply doesn't make the displayed value jump around.
+//
+// Not thread-safe, it's meant to be shared by games on the engine sequence.
+class RttCache {
+ public:
+  static constexpr base::TimeDelta kDefaultTtl = base::Minutes(5);
+
+  explicit RttCache(base::TimeDelta ttl = kDefaultTtl);
+  ~RttCache();
+
+  RttCache(const RttCache&) = delete;
+  RttCache& operator=(const RttCache&) = delete;
+
+  // Returns the smoothed RTT for `address` (IP:Port), even if it's expired.
+  std::optional<base::TimeDelta> Get(const std::string& address) const;
+
+  // Returns whether `address` was measured within the TTL and doesn't need to
+  // be probed again.
+  bool IsFresh(const std::string& address) const;
+
+  // Folds a new measurement into the entry for `address` and renews it.
+  // Returns the smoothed value.
+  base::TimeDelta AddSample(const std::string& address, base::TimeDelta rtt);
+
+ private:
+  struct Entry {
+    base::TimeDelta smoothed_rtt;
+    base::TimeTicks update_time;
+  };
+
+  void PruneExpiredEntries(base::TimeTicks now);
+
+  const base::TimeDelta ttl_;
+  std::unordered_map<std::string, Entry> entries_;
+  base::TimeTicks last_prune_time_;
+};
+
+}  // namespace engine::backend
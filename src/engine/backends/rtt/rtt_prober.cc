@@ -0,0 +1,353 @@
+#include "engine/backends/rtt/rtt_prober.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/threading/thread.h"
+#include "base/time/time_ticks.h"
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+namespace engine::backend {
+
+namespace {
+// Each running probe waits on its own socket event, next to the wakeup event,
+// so only this many fit in a single `WSAWaitForMultipleEvents()`. The rest are
+// queued until a slot frees up.
+constexpr size_t kMaxRunningProbes = WSA_MAXIMUM_WAIT_EVENTS - 1;
+const auto kPollRetryInterval = base::Milliseconds(10);
+
+// Large enough for any reply, of which only the arrival matters.
+constexpr int kReplyBufferSize = 2048;
+
+std::optional<sockaddr_storage> ParseAddress(const std::string& address,
+                                             int socket_type,
+                                             int* address_len) {
+  const size_t colon_pos = address.rfind(':');
+  if (colon_pos == std::string::npos)
+    return std::nullopt;
+
+  std::string host = address.substr(0, colon_pos);
+  const std::string port = address.substr(colon_pos + 1);
+  if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+    host = host.substr(1, host.size() - 2);
+
+  struct addrinfo hints{}, *res;
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = socket_type;
+  hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) != 0)
+    return std::nullopt;
+
+  sockaddr_storage addr{};
+  std::memcpy(&addr, res->ai_addr, res->ai_addrlen);
+  *address_len = (int)res->ai_addrlen;
+  freeaddrinfo(res);
+  return addr;
+}
+}  // namespace
+
+class RttProberImpl : public RttProber {
+ public:
+  RttProberImpl();
+  ~RttProberImpl() override;
+
+  // RttProber
+  void Probe(RttProbeRequest request,
+             base::OnceCallback<void(RttProbeResult)> on_done_callback)
+      override;
+
+ private:
+  struct RunningProbe {
+    SOCKET sock;
+    // Signaled on `FD_CONNECT` for TCP and `FD_READ` for UDP probes.
+    WSAEVENT event;
+    RttProbeProtocol protocol;
+    base::TimeTicks start_time;
+    base::TimeTicks deadline;
+    base::OnceCallback<void(RttProbeResult)> callback;
+  };
+
+  void InitializeOnWorker();
+  void ShutdownOnWorker();
+  void StartProbeOnWorker(
+      RttProbeRequest request,
+      base::OnceCallback<void(RttProbeResult)> on_done_callback);
+  void PollOnWorker();
+  bool WaitForEventsOnWorker(base::TimeTicks deadline);
+  std::optional<RttProbeResult> GetProbeResultOnWorker(
+      const RunningProbe& probe,
+      base::TimeTicks now);
+
+  base::Thread worker_thread_;
+  bool initialized_ = false;
+  bool polling_ = false;
+  std::vector<RunningProbe> running_probes_;
+  // Probes waiting for one of `kMaxRunningProbes` slots.
+  std::deque<std::pair<RttProbeRequest,
+                       base::OnceCallback<void(RttProbeResult)>>>
+      queued_probes_;
+  // Reused across waits: `wakeup_event_` followed by events of
+  // `running_probes_`.
+  std::vector<WSAEVENT> wait_events_;
+
+  // Signaled from any thread to interrupt the wait in the worker loop, e.g.
+  // when a new probe is posted or the prober is shutting down.
+  HANDLE wakeup_event_ = nullptr;
+  std::atomic<bool> shutting_down_{false};
+
+  base::WeakPtr<RttProberImpl> weak_this_;
+  base::WeakPtrFactory<RttProberImpl> weak_factory_;
+};
+
+// static
+std::unique_ptr<RttProber> RttProber::Create() {
+  return std::make_unique<RttProberImpl>();
+}
+
+RttProber::RttProber() = default;
+RttProber::~RttProber() = default;
+
+RttProberImpl::RttProberImpl() : weak_factory_(this) {
+  weak_this_ = weak_factory_.GetWeakPtr();
+  // Auto-reset, so a single wait consumes a single wakeup.
+  wakeup_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+  worker_thread_.Start();
+  worker_thread_.TaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&RttProberImpl::InitializeOnWorker, weak_this_));
+}
+
+RttProberImpl::~RttProberImpl() {
+  shutting_down_ = true;
+  SetEvent(wakeup_event_);
+  worker_thread_.Stop(
+      FROM_HERE, base::BindOnce(&RttProberImpl::ShutdownOnWorker, weak_this_));
+  CloseHandle(wakeup_event_);
+}
+
+void RttProberImpl::Probe(
+    RttProbeRequest request,
+    base::OnceCallback<void(RttProbeResult)> on_done_callback) {
+  worker_thread_.TaskRunner()->PostTask(
+      FROM_HERE,
+      base::BindOnce(&RttProberImpl::StartProbeOnWorker, weak_this_,
+                     std::move(request),
+                     base::BindToCurrentSequence(std::move(on_done_callback),
+                                                 FROM_HERE)));
+  // The worker may be blocked waiting for running probes, so make sure it
+  // starts this one right away.
+  SetEvent(wakeup_event_);
+}
+
+void RttProberImpl::InitializeOnWorker() {
+  WSADATA wsaData;
+  if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+    LOG(ERROR) << "WSAStartup failed in RttProberImpl";
+    return;
+  }
+  initialized_ = true;
+}
+
+void RttProberImpl::ShutdownOnWorker() {
+  for (auto& probe : running_probes_) {
+    closesocket(probe.sock);
+    WSACloseEvent(probe.event);
+  }
+  running_probes_.clear();
+  queued_probes_.clear();
+  if (initialized_)
+    WSACleanup();
+}
+
+void RttProberImpl::StartProbeOnWorker(
+    RttProbeRequest request,
+    base::OnceCallback<void(RttProbeResult)> on_done_callback) {
+  if (!initialized_ || shutting_down_) {
+    std::move(on_done_callback).Run(RttProbeResult{});
+    return;
+  }
+  if (running_probes_.size() >= kMaxRunningProbes) {
+    queued_probes_.emplace_back(std::move(request),
+                                std::move(on_done_callback));
+    return;
+  }
+
+  const bool is_tcp = request.protocol == RttProbeProtocol::kTcpConnect;
+  const int socket_type = is_tcp ? SOCK_STREAM : SOCK_DGRAM;
+  int addr_len = 0;
+  const auto addr = ParseAddress(request.address, socket_type, &addr_len);
+  if (!addr) {
+    LOG(WARNING) << "Invalid probe address: " << request.address;
+    std::move(on_done_callback).Run(RttProbeResult{});
+    return;
+  }
+
+  // `WSAEventSelect()` also makes the socket non-blocking.
+  SOCKET sock = socket(addr->ss_family, socket_type,
+                       is_tcp ? IPPROTO_TCP : IPPROTO_UDP);
+  WSAEVENT event = WSA_INVALID_EVENT;
+  if (sock == INVALID_SOCKET ||
+      (event = WSACreateEvent()) == WSA_INVALID_EVENT ||
+      WSAEventSelect(sock, event, is_tcp ? FD_CONNECT : FD_READ) ==
+          SOCKET_ERROR) {
+    LOG(ERROR) << "Failed to create probe socket: " << WSAGetLastError();
+    if (sock != INVALID_SOCKET)
+      closesocket(sock);
+    if (event != WSA_INVALID_EVENT)
+      WSACloseEvent(event);
+    std::move(on_done_callback).Run(RttProbeResult{});
+    return;
+  }
+
+  // Connected UDP sockets also report ICMP port unreachable as an error,
+  // instead of waiting for the timeout.
+  const auto start_time = base::TimeTicks::Now();
+  int result = connect(sock, (const sockaddr*)&*addr, addr_len);
+  if (result == SOCKET_ERROR && WSAGetLastError() != WSAEWOULDBLOCK) {
+    closesocket(sock);
+    WSACloseEvent(event);
+    std::move(on_done_callback)
+        .Run(RttProbeResult{RttProbeResult::Status::kFailed, {}});
+    return;
+  }
+  if (!is_tcp) {
+    result = send(sock, request.payload.data(), (int)request.payload.size(), 0);
+    if (result == SOCKET_ERROR) {
+      closesocket(sock);
+      WSACloseEvent(event);
+      std::move(on_done_callback)
+          .Run(RttProbeResult{RttProbeResult::Status::kFailed, {}});
+      return;
+    }
+  }
+
+  running_probes_.push_back(RunningProbe{
+      sock,
+      event,
+      request.protocol,
+      start_time,
+      start_time + request.timeout,
+      std::move(on_done_callback),
+  });
+
+  if (!polling_) {
+    polling_ = true;
+    PollOnWorker();
+  }
+}
+
+void RttProberImpl::PollOnWorker() {
+  if (running_probes_.empty() || shutting_down_) {
+    polling_ = false;
+    return;
+  }
+
+  auto next_deadline = running_probes_.front().deadline;
+  for (const auto& probe : running_probes_)
+    next_deadline = (std::min)(next_deadline, probe.deadline);
+  if (!WaitForEventsOnWorker(next_deadline)) {
+    worker_thread_.TaskRunner()->PostDelayedTask(
+        FROM_HERE, base::BindOnce(&RttProberImpl::PollOnWorker, weak_this_),
+        kPollRetryInterval);
+    return;
+  }
+  const auto now = base::TimeTicks::Now();
+
+  // Callbacks are posted to their own sequences, so these can run while
+  // iterating.
+  size_t kept = 0;
+  for (size_t idx = 0; idx < running_probes_.size(); ++idx) {
+    auto& probe = running_probes_[idx];
+    auto result = GetProbeResultOnWorker(probe, now);
+    if (!result && now < probe.deadline) {
+      if (kept != idx)
+        running_probes_[kept] = std::move(probe);
+      ++kept;
+      continue;
+    }
+
+    closesocket(probe.sock);
+    WSACloseEvent(probe.event);
+    std::move(probe.callback)
+        .Run(result.value_or(
+            RttProbeResult{RttProbeResult::Status::kTimedOut, {}}));
+  }
+  running_probes_.resize(kept);
+
+  while (!queued_probes_.empty() &&
+         running_probes_.size() < kMaxRunningProbes) {
+    auto [request, callback] = std::move(queued_probes_.front());
+    queued_probes_.pop_front();
+    StartProbeOnWorker(std::move(request), std::move(callback));
+  }
+
+  // Re-post instead of looping so that probes which woke us up get to start
+  // before we wait again.
+  worker_thread_.TaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&RttProberImpl::PollOnWorker, weak_this_));
+}
+
+bool RttProberImpl::WaitForEventsOnWorker(base::TimeTicks deadline) {
+  const auto remaining = deadline - base::TimeTicks::Now();
+  // Round up so that we never wake up right before the deadline and spin.
+  const DWORD timeout_ms = static_cast<DWORD>(
+      (std::max)(int64_t{0}, remaining.InMilliseconds() + 1));
+
+  wait_events_.clear();
+  wait_events_.push_back(wakeup_event_);
+  for (const auto& probe : running_probes_)
+    wait_events_.push_back(probe.event);
+
+  const DWORD result =
+      WSAWaitForMultipleEvents(static_cast<DWORD>(wait_events_.size()),
+                               wait_events_.data(), FALSE, timeout_ms, FALSE);
+  if (result == WSA_WAIT_FAILED) {
+    LOG(ERROR) << "Failed to wait for probe socket events: "
+               << WSAGetLastError();
+    return false;
+  }
+  return true;
+}
+
+std::optional<RttProbeResult> RttProberImpl::GetProbeResultOnWorker(
+    const RunningProbe& probe,
+    base::TimeTicks now) {
+  WSANETWORKEVENTS network_events;
+  if (WSAEnumNetworkEvents(probe.sock, probe.event, &network_events) ==
+      SOCKET_ERROR) {
+    LOG(ERROR) << "Failed to get probe socket events: " << WSAGetLastError();
+    return RttProbeResult{RttProbeResult::Status::kFailed, {}};
+  }
+
+  // A refused connection is a failure too. Windows retries the SYN after a
+  // reset, so the refusal is reported only after the retries' delay, which
+  // says nothing about the round trip time.
+  if (probe.protocol == RttProbeProtocol::kTcpConnect) {
+    if (!(network_events.lNetworkEvents & FD_CONNECT))
+      return std::nullopt;
+    if (network_events.iErrorCode[FD_CONNECT_BIT] != 0)
+      return RttProbeResult{RttProbeResult::Status::kFailed, {}};
+    return RttProbeResult{RttProbeResult::Status::kOk,
+                          now - probe.start_time};
+  }
+
+  if (!(network_events.lNetworkEvents & FD_READ))
+    return std::nullopt;
+  // ICMP port unreachable is reported by `recv()` of the connected socket.
+  char reply[kReplyBufferSize];
+  if (network_events.iErrorCode[FD_READ_BIT] != 0 ||
+      (recv(probe.sock, reply, sizeof(reply), 0) == SOCKET_ERROR &&
+       WSAGetLastError() != WSAEMSGSIZE)) {
+    return RttProbeResult{RttProbeResult::Status::kFailed, {}};
+  }
+  return RttProbeResult{RttProbeResult::Status::kOk, now - probe.start_time};
+}
+
+}  // namespace engine::backend
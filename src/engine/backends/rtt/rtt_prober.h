@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "base/callback.h"
+#include "base/time/time_delta.h"
+
+namespace engine::backend {
+
+enum class RttProbeProtocol {
+  // Measures the TCP handshake, without sending any data.
+  kTcpConnect,
+  // Sends `payload` and waits for the first datagram in reply.
+  kUdp,
+};
+
+struct RttProbeRequest {
+  std::string address;  // IP:Port
+  RttProbeProtocol protocol = RttProbeProtocol::kTcpConnect;
+  std::string payload;
+  base::TimeDelta timeout = base::Seconds(1);
+};
+
+struct RttProbeResult {
+  enum class Status {
+    kOk,
+    // The server is unreachable, e.g. refused TCP connection, UDP port
+    // unreachable or no route.
+    kFailed,
+    kTimedOut,
+    // Nothing was sent, e.g. because the address isn't a numeric IP:Port or
+    // a socket couldn't be created.
+    kNotStarted,
+  };
+
+  Status status = Status::kNotStarted;
+  // Only valid with `kOk`.
+  base::TimeDelta rtt;
+};
+
+// Measures round trip times to servers with raw sockets, all multiplexed on a
+// single worker thread. Timestamps are taken as soon as the socket becomes
+// ready, so these don't include any protocol overhead on top of the probe.
+class RttProber {
+ public:
+  static std::unique_ptr<RttProber> Create();
+
+  RttProber();
+  virtual ~RttProber();
+
+  // `on_done_callback` runs on the calling sequence.
+  virtual void Probe(RttProbeRequest request,
+                     base::OnceCallback<void(RttProbeResult)>
+                         on_done_callback) = 0;
+};
+
+}  // namespace engine::backend
@@ -195,7 +195,7 @@ const game::Game* AppEngineImpl::LoadGame(const std::string& game,
     games_[game] = std::make_unique<game::PavlovGame>(
         base::BindRepeating(&SetGameStatusText, presenter_, game),
         base::BindRepeating(&ReportGameMessage, presenter_), pavlov_config,
-        steam_auth_backend_command_);
+        steam_auth_backend_command_, &rtt_cache_);
     return games_[game].get();
   }
   if (game == "Contractors") {
@@ -218,7 +218,8 @@ const game::Game* AppEngineImpl::LoadGame(const std::string& game,
 
     games_[game] = std::make_unique<game::Quake3Game>(
         base::BindRepeating(&SetGameStatusText, presenter_, game),
-        base::BindRepeating(&ReportGameMessage, presenter_), quake3_config);
+        base::BindRepeating(&ReportGameMessage, presenter_), quake3_config,
+        &rtt_cache_);
     return games_[game].get();
   }
 
@@ -4,6 +4,7 @@
 #include <memory>
 #include <string>
 
+#include "engine/backends/rtt/rtt_cache.h"
 #include "engine/config/config_loader.h"
 #include "engine/engine.h"
 #include "engine/games/game.h"
@@ -68,6 +69,9 @@ class AppEngineImpl : public AppEngine {
   std::string steam_auth_backend_command_;
   Presenter* presenter_;
   config::ConfigLoader config_;
+  // Shared by games, so that pings measured by one search are reused by the
+  // following ones.
+  backend::RttCache rtt_cache_;
   std::map<std::string, std::unique_ptr<game::Game>> games_;
 };
 
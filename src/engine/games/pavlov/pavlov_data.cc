@@ -211,6 +211,8 @@ void to_json(nlohmann::json& out, const PavlovConfig& obj) {
   out = {
       {"game_version", obj.game_version},
       {"filters", obj.filters},
+      {"ping_max_in_flight", obj.ping_max_in_flight},
+      {"ping_timeout_ms", obj.ping_timeout_ms},
   };
   if (!obj.favorite_players.empty()) {
     out["favorite_players"] = obj.favorite_players;
@@ -221,6 +223,8 @@ void from_json(const nlohmann::json& in, PavlovConfig& obj) {
   obj.game_version = in.value("game_version", "");
   obj.filters = in.value("filters", PavlovFilters{});
   obj.favorite_players = in.value("favorite_players", std::set<std::string>{});
+  obj.ping_max_in_flight = in.value("ping_max_in_flight", 32);
+  obj.ping_timeout_ms = in.value("ping_timeout_ms", 999);
 }
 
 void from_json(const nlohmann::json& in, PavlovServer& obj) {
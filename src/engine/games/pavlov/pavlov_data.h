@@ -68,6 +68,8 @@ struct PavlovConfig {
   std::string game_version;
   PavlovFilters filters;
   std::set<std::string> favorite_players;
+  int ping_max_in_flight = 32;
+  int ping_timeout_ms = 999;
 };
 
 struct PavlovServer {
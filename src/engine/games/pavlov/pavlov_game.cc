@@ -1,5 +1,6 @@
 #include "engine/games/pavlov/pavlov_game.h"
 
+#include <algorithm>
 #include <format>
 #include <iostream>
 #include <memory>
@@ -13,6 +14,9 @@
 
 #include "engine/backends/eos/eos_data.h"
 #include "engine/backends/pavlov/pavlov_lobby_backend.h"
+#include "engine/backends/rtt/rtt_cache.h"
+#include "engine/games/pavlov/pavlov_lobby_searcher.h"
+#include "engine/games/pavlov/pavlov_server_list_parser.h"
 #include "utils/strings.h"
 
 namespace engine::game {
@@ -22,6 +26,9 @@ namespace {
 // Enable computing server pings (requires per-server network requests)
 const bool kEnableComputingServerPings = true;
 
+// Partial results are delivered at most this often while pings are measured.
+const auto kPartialResultsInterval = base::Milliseconds(250);
+
 const auto kPavlovEosEmptyCriteria = backend::eos::SearchLobbiesCriteria{
     "attributes.VERSION_s",
     backend::eos::CriteriaOperator::NOT_EQUAL,
@@ -55,26 +62,6 @@ backend::eos::SearchLobbiesRequest MakeEosRequest(
   eos_request.max_results = max_results;
   eos_request.min_current_players = min_current_players;
 
-  if (!filters.game_modes.AllEnabled()) {
-    if (auto game_modes = filters.game_modes.ToVec(); !game_modes.empty()) {
-      eos_request.criteria.push_back(backend::eos::SearchLobbiesCriteria{
-          "attributes.GAMETYPE_s",
-          backend::eos::CriteriaOperator::ANY_OF,
-          std::move(game_modes),
-      });
-    }
-  }
-
-  if (!filters.host_modes.regions.AllEnabled()) {
-    if (auto regions = filters.host_modes.regions.ToVec(); !regions.empty()) {
-      eos_request.criteria.push_back(backend::eos::SearchLobbiesCriteria{
-          "attributes.REGION_s",
-          backend::eos::CriteriaOperator::ANY_OF,
-          std::move(regions),
-      });
-    }
-  }
-
   if (!filters.host_modes.crossplay) {
     eos_request.criteria.push_back(backend::eos::SearchLobbiesCriteria{
         "attributes.CROSSPLATFORM_s",
@@ -92,6 +79,52 @@ backend::eos::SearchLobbiesRequest MakeEosRequest(
   return eos_request;
 }
 
+// Lobby searches that hit their result limit are split by region first and by
+// game mode next, each restricted to the enabled ones (if any).
+std::vector<pavlov::LobbySearchPartition> MakeEosSearchPartitions(
+    const pavlov::PavlovFilters& filters) {
+  const auto all_regions = pavlov::PavlovHostRegions{
+      .america = true,
+      .europe = true,
+      .asia_pacific = true,
+  };
+  const auto all_game_modes = pavlov::PavlovGameModeFilters{
+      .dm = true,
+      .tdm = true,
+      .snd = true,
+      .gun = true,
+      .ww2tdm = true,
+      .ww2gun = true,
+      .custom = true,
+      .ttt = true,
+      .oitc = true,
+      .hide = true,
+      .push = true,
+      .zombies = true,
+      .ph = true,
+      .infection = true,
+      .koth = true,
+      .all = false,
+  };
+
+  const bool all_regions_enabled = filters.host_modes.regions.AllEnabled();
+  const bool all_game_modes_enabled = filters.game_modes.AllEnabled();
+  return {
+      pavlov::LobbySearchPartition{
+          "attributes.REGION_s",
+          all_regions_enabled ? all_regions.ToVec()
+                              : filters.host_modes.regions.ToVec(),
+          all_regions_enabled,
+      },
+      pavlov::LobbySearchPartition{
+          "attributes.GAMETYPE_s",
+          all_game_modes_enabled ? all_game_modes.ToVec()
+                                 : filters.game_modes.ToVec(),
+          all_game_modes_enabled,
+      },
+  };
+}
+
 model::GameSearchResults FilterModelResultsFunction(
     const model::GameSearchResults& unfiltered_results,
     const model::GameFilters& model_filters) {
@@ -135,6 +168,63 @@ model::GameSearchResults FilterModelResultsFunction(
   return filtered_results;
 }
 
+model::GameServerLobbyResult ToModelResult(
+    const pavlov::PavlovLobbyServer& result) {
+  std::string flags;
+  if (result.locked) {
+    flags += "🔒";
+  }
+  if (result.crossplatform) {
+    flags += "⫘";
+  } else if (!flags.empty()) {
+    flags += "     ";
+  }
+
+  const auto* platform_str =
+      [](std::optional<pavlov::PavlovPlatform> platform) {
+        if (!platform) {
+          return "Unknown";
+        }
+        switch (*platform) {
+          case pavlov::PavlovPlatform::kPCVR:
+            return "PC VR";
+          case pavlov::PavlovPlatform::kPSVR2:
+            return "PS VR2";
+        }
+      }(result.platform);
+
+  return model::GameServerLobbyResult{
+      {
+          result.id,
+          result.gamemode,
+          result.name_owner,
+          result.map_label,
+          std::to_string(result.players) + "/" +
+              std::to_string(result.max_players),
+          result.region,
+          platform_str,
+          flags,
+      },
+      {
+          {"pin", result.pin},
+      }};
+}
+
+std::string FormatPing(base::TimeDelta ping) {
+  return std::to_string(ping.InMilliseconds()) + "ms";
+}
+
+int ParseConfigNumber(const std::string& value,
+                      int fallback,
+                      int min_value,
+                      int max_value) {
+  try {
+    return std::clamp(std::stoi(value), min_value, max_value);
+  } catch (...) {
+    return fallback;
+  }
+}
+
 std::string ConvertTimestamp(const std::string input_time) {
   std::istringstream in{input_time};
   std::chrono::sys_seconds tp;
@@ -150,10 +240,12 @@ std::string ConvertTimestamp(const std::string input_time) {
 PavlovGame::PavlovGame(SetStatusTextCallback set_status_text,
                        ReportMessageCallback report_message,
                        nlohmann::json game_config,
-                       std::string steam_auth_backend_command)
+                       std::string steam_auth_backend_command,
+                       backend::RttCache* rtt_cache)
     : BaseGame(std::move(set_status_text), std::move(report_message)),
       config_(),
       lobby_backend_(nullptr),
+      rtt_cache_(rtt_cache),
       weak_factory_(this) {
   weak_this_ = weak_factory_.GetWeakPtr();
 
@@ -168,6 +260,8 @@ PavlovGame::PavlovGame(SetStatusTextCallback set_status_text,
 
   lobby_backend_ = std::make_unique<backend::PavlovLobbyBackend>(
       std::move(steam_auth_backend_command));
+  lobby_searcher_ =
+      std::make_unique<pavlov::PavlovLobbySearcher>(lobby_backend_.get());
 }
 
 PavlovGame::~PavlovGame() = default;
@@ -338,7 +432,11 @@ model::Game PavlovGame::GetModel() const {
 }
 
 nlohmann::json PavlovGame::UpdateConfig(model::GameFilters search_filters) {
-  config_.filters = pavlov::FromModel(std::move(search_filters));
+  // Committing other config options (see `CommitConfig()`) passes no filters,
+  // which mustn't reset the saved ones.
+  if (!search_filters.empty()) {
+    config_.filters = pavlov::FromModel(std::move(search_filters));
+  }
   return config_;
 }
 
@@ -353,6 +451,10 @@ void PavlovGame::SearchLobbiesAndServers(
 
   SetStatusText("Waiting for results...");
 
+  auto state = std::make_shared<SearchState>();
+  state->search_id = ++last_search_id_;
+  state->partial_results_callback = std::move(request.partial_results_callback);
+
   const size_t barrier_count =
       request_filters.host_modes.lobby + request_filters.host_modes.server;
   auto response_callback = base::BarrierCallback<pavlov::PavlovSearchResponse>(
@@ -362,10 +464,11 @@ void PavlovGame::SearchLobbiesAndServers(
                                weak_this_, std::move(on_done_callback))));
 
   if (request_filters.host_modes.lobby) {
-    auto eos_request = MakeEosRequest(request_filters);
-    lobby_backend_->SearchLobbies(
-        std::move(eos_request), base::BindOnce(&PavlovGame::OnSearchLobbiesDone,
-                                               weak_this_, response_callback));
+    lobby_searcher_->SearchLobbies(
+        MakeEosRequest(request_filters),
+        MakeEosSearchPartitions(request_filters),
+        base::BindOnce(&PavlovGame::OnSearchLobbiesDone, weak_this_, state,
+                       response_callback));
   }
   if (request_filters.host_modes.server) {
     if (config_.game_version.empty()) {
@@ -376,11 +479,12 @@ void PavlovGame::SearchLobbiesAndServers(
           base::BindOnce(&PavlovGame::UpdateGameVersionFromLobbyResults,
                          weak_this_)
               .Then(base::BindOnce(&PavlovGame::RequestServerList, weak_this_,
-                                   request_filters, response_callback)));
+                                   state, request_filters,
+                                   response_callback)));
       return;
     }
 
-    RequestServerList(request_filters, response_callback);
+    RequestServerList(state, request_filters, response_callback);
   }
 
   // Request player list if asked for it
@@ -389,8 +493,8 @@ void PavlovGame::SearchLobbiesAndServers(
     const auto kMaxLobbies = 400;
     auto eos_request = backend::eos::SearchLobbiesRequest{
         {kPavlovEosEmptyCriteria}, kMinPlayers, kMaxLobbies};
-    lobby_backend_->SearchLobbies(
-        std::move(eos_request),
+    lobby_searcher_->SearchLobbies(
+        std::move(eos_request), MakeEosSearchPartitions({}),
         base::BindOnce(&PavlovGame::OnSearchLobbiesForPlayersDone, weak_this_,
                        std::move(request.players_callback)));
   }
@@ -449,6 +553,55 @@ void PavlovGame::RemovePlayerFromFavorites(std::string player_id) {
   config_.favorite_players.erase(player_id);
 }
 
+model::GameConfigDescriptor PavlovGame::GetConfigDescriptor() const {
+  model::GameConfigDescriptor descriptor;
+
+  // Network tab
+  model::GameConfigSection network;
+  network.name = "Network";
+  network.options.push_back({
+      "ping_max_in_flight",
+      "Max pending server pings",
+      "Maximum number of servers pinged at the same time, lower this if "
+      "pings are too high after refresh",
+      model::GameConfigOptionType::kString,
+      std::to_string(config_.ping_max_in_flight),
+      {},  // list_columns
+      {},  // list_items
+  });
+  network.options.push_back({
+      "ping_timeout_ms",
+      "Server ping timeout (ms)",
+      "Servers which don't respond in time are shown with 999ms ping",
+      model::GameConfigOptionType::kString,
+      std::to_string(config_.ping_timeout_ms),
+      {},  // list_columns
+      {},  // list_items
+  });
+  descriptor.sections.push_back(std::move(network));
+
+  return descriptor;
+}
+
+void PavlovGame::UpdateConfigOption(std::string key, std::string value) {
+  if (key == "ping_max_in_flight") {
+    config_.ping_max_in_flight =
+        ParseConfigNumber(value, config_.ping_max_in_flight, 1, 256);
+  } else if (key == "ping_timeout_ms") {
+    config_.ping_timeout_ms =
+        ParseConfigNumber(value, config_.ping_timeout_ms, 100, 5000);
+  }
+}
+
+bool PavlovGame::CommitConfig(model::GameConfigDescriptor descriptor) {
+  for (const auto& section : descriptor.sections) {
+    for (const auto& option : section.options) {
+      UpdateConfigOption(option.key, option.value);
+    }
+  }
+  return false;
+}
+
 // static
 pavlov::PavlovSearchResponse PavlovGame::CombineSearchResponses(
     std::vector<pavlov::PavlovSearchResponse> responses) {
@@ -519,6 +672,7 @@ void PavlovGame::UpdateGameVersionFromLobbySession(
 }
 
 void PavlovGame::RequestServerList(
+    std::shared_ptr<SearchState> state,
     pavlov::PavlovFilters request,
     base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback) {
   DLOG_IF(ERROR, config_.game_version.empty())
@@ -530,10 +684,11 @@ void PavlovGame::RequestServerList(
   base::net::SimpleUrlLoader::DownloadLimited(
       base::net::ResourceRequest{url}, kMaxResponseSize,
       base::BindOnce(&PavlovGame::OnSearchServersDone, weak_this_,
-                     std::move(on_done_callback)));
+                     std::move(state), std::move(on_done_callback)));
 }
 
 void PavlovGame::OnSearchLobbiesDone(
+    std::shared_ptr<SearchState> state,
     base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback,
     backend::Result result,
     backend::eos::SearchLobbiesResponse response) {
@@ -556,6 +711,9 @@ void PavlovGame::OnSearchLobbiesDone(
     results.push_back(pavlov::PavlovLobbyServer{lobby});
   }
 
+  state->lobbies = results;
+  DeliverPartialResults(*state, /*force=*/true);
+
   std::move(on_done_callback)
       .Run(pavlov::PavlovSearchResponse{true, "", std::move(results)});
 }
@@ -596,6 +754,7 @@ void PavlovGame::OnSearchLobbiesForPlayersDone(
 }
 
 void PavlovGame::OnSearchServersDone(
+    std::shared_ptr<SearchState> state,
     base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback,
     base::net::ResourceResponse response) {
   SetStatusText("Received server results, waiting for rest.");
@@ -617,78 +776,105 @@ void PavlovGame::OnSearchServersDone(
   }
 
   std::vector<pavlov::PavlovLobbyServer> results;
-  try {
-    nlohmann::json json_response = nlohmann::json::parse(response.data);
-    pavlov::PavlovServerListResponse server_list_response = json_response;
-
-    for (const auto& server : server_list_response.servers) {
-      results.emplace_back(pavlov::PavlovLobbyServer{server});
-    }
-
-  } catch (const std::exception& e) {
+  std::string parse_error;
+  if (!pavlov::ParseServerListResponse(response.data, &results,
+                                       &parse_error)) {
     std::move(on_done_callback)
         .Run(pavlov::PavlovSearchResponse{
             false,
-            "Failed to parse server list: " + std::string(e.what()),
+            "Failed to parse server list: " + parse_error,
             {},
         });
+    return;
   }
 
-  auto search_response = pavlov::PavlovSearchResponse{true, "", results};
-
-  if (kEnableComputingServerPings) {
-    auto got_ping_callback =
-        base::BarrierCallback<std::pair<std::string, base::TimeDelta>>(
-            results.size(),
-            base::BindOnce(&PavlovGame::OnAllServersPingsReceived, weak_this_,
-                           std::move(on_done_callback),
-                           std::move(search_response)));
-
-    for (const auto& result : results) {
-      const auto kResponseMaxSize = 16 * 1024;
-      base::net::SimpleUrlLoader::DownloadLimited(
-          base::net::ResourceRequest{result.ip + ":" +
-                                     std::to_string(result.port)}
-              .WithFollowRedirects(false)
-              .WithHeadersOnly()
-              .WithTimeout(base::Milliseconds(999)),
-          kResponseMaxSize,
-          base::BindOnce(&PavlovGame::OnServerPingReceived, weak_this_,
-                         got_ping_callback, result.id));
+  if (!kEnableComputingServerPings) {
+    std::move(on_done_callback)
+        .Run(pavlov::PavlovSearchResponse{true, "", std::move(results)});
+    return;
+  }
+
+  // Servers measured recently keep their cached ping, the rest show the last
+  // known one (if any) until they're probed again.
+  std::vector<pavlov::PavlovServerPinger::Target> targets;
+  for (size_t idx = 0; idx < results.size(); ++idx) {
+    auto& server = results[idx];
+    auto address = server.ip + ":" + std::to_string(server.port);
+    state->server_indices[server.id] = idx;
+
+    if (auto cached_ping = rtt_cache_->Get(address)) {
+      server.region = FormatPing(*cached_ping);
+    }
+    if (!rtt_cache_->IsFresh(address)) {
+      targets.push_back(pavlov::PavlovServerPinger::Target{
+          server.id,
+          std::move(address),
+      });
     }
-  } else {
-    std::move(on_done_callback).Run(std::move(search_response));
   }
+  state->servers = std::move(results);
+
+  // List servers right away, pings are filled in as they're measured.
+  DeliverPartialResults(*state, /*force=*/true);
+
+  server_pinger_.PingServers(
+      std::move(targets), static_cast<size_t>(config_.ping_max_in_flight),
+      base::Milliseconds(config_.ping_timeout_ms),
+      base::BindRepeating(&PavlovGame::OnServerPingReceived, weak_this_,
+                          state),
+      base::BindOnce(&PavlovGame::OnAllServersPingsReceived, weak_this_, state,
+                     std::move(on_done_callback)));
 }
 
-void PavlovGame::OnServerPingReceived(
-    base::OnceCallback<void(std::pair<std::string, base::TimeDelta>)>
-        on_done_callback,
-    std::string result_id,
-    base::net::ResourceResponse response) {
-  auto ping = base::Milliseconds(999);
-  if (response.result == base::net::Result::kOk) {
-    ping = response.timing_connect - response.timing_queue;
+void PavlovGame::OnServerPingReceived(std::shared_ptr<SearchState> state,
+                                      std::string result_id,
+                                      std::optional<base::TimeDelta> ping) {
+  auto index_it = state->server_indices.find(result_id);
+  if (index_it == state->server_indices.end()) {
+    return;
   }
-  std::move(on_done_callback).Run(std::make_pair(std::move(result_id), ping));
+
+  auto& server = state->servers[index_it->second];
+  if (ping) {
+    server.region = FormatPing(rtt_cache_->AddSample(
+        server.ip + ":" + std::to_string(server.port), *ping));
+  } else {
+    server.region = FormatPing(base::Milliseconds(999));
+  }
+
+  DeliverPartialResults(*state, /*force=*/false);
 }
 
 void PavlovGame::OnAllServersPingsReceived(
-    base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback,
-    pavlov::PavlovSearchResponse partial_response,
-    std::vector<std::pair<std::string, base::TimeDelta>> id_to_ping_vec) {
-  std::unordered_map<std::string, base::TimeDelta> id_to_ping{
-      id_to_ping_vec.begin(), id_to_ping_vec.end()};
-
-  for (auto& result : partial_response.results) {
-    auto result_ping_it = id_to_ping.find(result.id);
-    if (result_ping_it != id_to_ping.end()) {
-      result.region =
-          std::to_string(result_ping_it->second.InMilliseconds()) + "ms";
-    }
+    std::shared_ptr<SearchState> state,
+    base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback) {
+  std::move(on_done_callback)
+      .Run(pavlov::PavlovSearchResponse{true, "", std::move(state->servers)});
+  state->servers.clear();
+  state->server_indices.clear();
+}
+
+void PavlovGame::DeliverPartialResults(SearchState& state, bool force) {
+  // Late results of a previous search would replace the current ones.
+  if (!state.partial_results_callback || state.search_id != last_search_id_) {
+    return;
   }
 
-  std::move(on_done_callback).Run(std::move(partial_response));
+  const auto now = base::TimeTicks::Now();
+  if (!force && now - state.last_partial_delivery_time <
+                    kPartialResultsInterval) {
+    return;
+  }
+  state.last_partial_delivery_time = now;
+
+  model::GameSearchResults results;
+  for (const auto& lobby : state.lobbies) {
+    results.lobbies.push_back(ToModelResult(lobby));
+  }
+  for (const auto& server : state.servers) {
+    results.lobbies.push_back(ToModelResult(server));
+  }
+  state.partial_results_callback.Run(std::move(results));
 }
 
 void PavlovGame::StoreAndConvertSearchResults(
@@ -715,44 +901,7 @@ void PavlovGame::StoreAndConvertSearchResults(
 
   if (last_search_results_) {
     for (const auto& result : *last_search_results_) {
-      std::string flags;
-      if (result.locked) {
-        flags += "🔒";
-      }
-      if (result.crossplatform) {
-        flags += "⫘";
-      } else if (!flags.empty()) {
-        flags += "     ";
-      }
-
-      const auto* platform_str =
-          [](std::optional<pavlov::PavlovPlatform> platform) {
-            if (!platform) {
-              return "Unknown";
-            }
-            switch (*platform) {
-              case pavlov::PavlovPlatform::kPCVR:
-                return "PC VR";
-              case pavlov::PavlovPlatform::kPSVR2:
-                return "PS VR2";
-            }
-          }(result.platform);
-
-      model_response.results.lobbies.emplace_back(model::GameServerLobbyResult{
-          {
-              result.id,
-              result.gamemode,
-              result.name_owner,
-              result.map_label,
-              std::to_string(result.players) + "/" +
-                  std::to_string(result.max_players),
-              result.region,
-              platform_str,
-              flags,
-          },
-          {
-              {"pin", result.pin},
-          }});
+      model_response.results.lobbies.push_back(ToModelResult(result));
     }
   }
 
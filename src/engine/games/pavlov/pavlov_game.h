@@ -1,10 +1,13 @@
 #pragma once
 
+#include <memory>
+#include <unordered_map>
 #include <utility>
 
 #include "base/memory/weak_ptr.h"
 #include "base/net/resource_response.h"
 #include "base/time/time_delta.h"
+#include "base/time/time_ticks.h"
 #include "nlohmann/json.hpp"
 
 #include "engine/backends/eos/eos_data.h"
@@ -13,19 +16,26 @@
 #include "engine/games/base_game.h"
 #include "engine/games/pavlov/pavlov_data.h"
 #include "engine/games/pavlov/pavlov_players_data_store.h"
+#include "engine/games/pavlov/pavlov_server_pinger.h"
 
 namespace engine::backend {
 class PavlovLobbyBackend;
+class RttCache;
 }  // namespace engine::backend
 
 namespace engine::game {
 
+namespace pavlov {
+class PavlovLobbySearcher;
+}  // namespace pavlov
+
 class PavlovGame : public BaseGame {
  public:
   PavlovGame(SetStatusTextCallback set_status_text,
              ReportMessageCallback report_message,
              nlohmann::json game_config,
-             std::string steam_auth_backend_command);
+             std::string steam_auth_backend_command,
+             backend::RttCache* rtt_cache);
   ~PavlovGame() override;
 
   // Game
@@ -44,8 +54,23 @@ class PavlovGame : public BaseGame {
   bool IsPlayerInFavorites(std::string player_id) const override;
   void AddPlayerToFavorites(std::string player_id) override;
   void RemovePlayerFromFavorites(std::string player_id) override;
+  model::GameConfigDescriptor GetConfigDescriptor() const override;
+  void UpdateConfigOption(std::string key, std::string value) override;
+  bool CommitConfig(model::GameConfigDescriptor descriptor) override;
 
  private:
+  // Results of a search received so far. Servers are listed right away and
+  // their pings filled in as these are measured.
+  struct SearchState {
+    int search_id = 0;
+    base::RepeatingCallback<void(model::GameSearchResults)>
+        partial_results_callback;
+    std::vector<pavlov::PavlovLobbyServer> lobbies;
+    std::vector<pavlov::PavlovLobbyServer> servers;
+    std::unordered_map<std::string, size_t> server_indices;
+    base::TimeTicks last_partial_delivery_time;
+  };
+
   static pavlov::PavlovSearchResponse CombineSearchResponses(
       std::vector<pavlov::PavlovSearchResponse> responses);
 
@@ -55,9 +80,11 @@ class PavlovGame : public BaseGame {
   void UpdateGameVersionFromLobbySession(
       const backend::eos::SearchLobbiesSession& session);
   void RequestServerList(
+      std::shared_ptr<SearchState> state,
       pavlov::PavlovFilters request,
       base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback);
   void OnSearchLobbiesDone(
+      std::shared_ptr<SearchState> state,
       base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback,
       backend::Result result,
       backend::eos::SearchLobbiesResponse response);
@@ -66,18 +93,16 @@ class PavlovGame : public BaseGame {
       backend::Result result,
       backend::eos::SearchLobbiesResponse response);
   void OnSearchServersDone(
+      std::shared_ptr<SearchState> state,
       base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback,
       base::net::ResourceResponse response);
-  void OnServerPingReceived(
-      base::OnceCallback<void(std::pair<std::string, base::TimeDelta>)>
-          on_done_callback,
-      std::string result_id,
-      base::net::ResourceResponse response);
+  void OnServerPingReceived(std::shared_ptr<SearchState> state,
+                            std::string result_id,
+                            std::optional<base::TimeDelta> ping);
   void OnAllServersPingsReceived(
-      base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback,
-      pavlov::PavlovSearchResponse partial_response,
-      std::vector<std::pair<std::string, base::TimeDelta>>
-          result_id_to_ping_vec);
+      std::shared_ptr<SearchState> state,
+      base::OnceCallback<void(pavlov::PavlovSearchResponse)> on_done_callback);
+  void DeliverPartialResults(SearchState& state, bool force);
   void StoreAndConvertSearchResults(
       base::OnceCallback<void(model::SearchResponse)> on_done_callback,
       pavlov::PavlovSearchResponse response);
@@ -101,7 +126,11 @@ class PavlovGame : public BaseGame {
 
   pavlov::PavlovConfig config_;
   std::unique_ptr<backend::PavlovLobbyBackend> lobby_backend_;
+  std::unique_ptr<pavlov::PavlovLobbySearcher> lobby_searcher_;
   pavlov::PavlovPlayersDataStore players_data_store_;
+  backend::RttCache* rtt_cache_;
+  pavlov::PavlovServerPinger server_pinger_;
+  int last_search_id_ = 0;
   std::optional<std::vector<pavlov::PavlovLobbyServer>> last_search_results_;
   std::optional<
       std::pair<model::SearchDetailsRequest,
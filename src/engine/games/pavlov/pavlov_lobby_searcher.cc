@@ -0,0 +1,194 @@
+#include "engine/games/pavlov/pavlov_lobby_searcher.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_set>
+#include <utility>
+
+#include "base/logging.h"
+#include "engine/backends/eos/eos_lobby_backend.h"
+#include "utils/vectors.h"
+
+namespace engine::game::pavlov {
+
+namespace {
+
+// Each split divides a shard's values into at most this many shards, plus one
+// for other values.
+const size_t kMaxShardsPerSplit = 4;
+
+// Limits the number of requests of a single search, in case many shards keep
+// hitting `max_results`.
+const int kMaxShardsPerSearch = 32;
+
+}  // namespace
+
+struct PavlovLobbySearcher::SearchState {
+  backend::eos::SearchLobbiesRequest request;
+  std::vector<LobbySearchPartition> partitions;
+  base::OnceCallback<void(backend::Result, backend::eos::SearchLobbiesResponse)>
+      callback;
+
+  int started_shards = 0;
+  int pending_shards = 0;
+  int succeeded_shards = 0;
+  std::optional<backend::Result> first_error;
+  std::unordered_set<std::string> lobby_ids;
+  backend::eos::SearchLobbiesResponse response;
+};
+
+PavlovLobbySearcher::PavlovLobbySearcher(
+    backend::EosLobbyBackend* lobby_backend)
+    : lobby_backend_(lobby_backend), weak_factory_(this) {
+  weak_this_ = weak_factory_.GetWeakPtr();
+}
+
+PavlovLobbySearcher::~PavlovLobbySearcher() = default;
+
+void PavlovLobbySearcher::SearchLobbies(
+    backend::eos::SearchLobbiesRequest request,
+    std::vector<LobbySearchPartition> partitions,
+    base::OnceCallback<void(backend::Result,
+                            backend::eos::SearchLobbiesResponse)>
+        on_done_callback) {
+  auto state = std::make_shared<SearchState>();
+  state->request = std::move(request);
+  state->partitions = std::move(partitions);
+  state->callback = std::move(on_done_callback);
+
+  Shard root_shard;
+  for (const auto& partition : state->partitions) {
+    root_shard.push_back(ShardAttribute{
+        partition.include_other_values ? std::vector<std::string>{}
+                                       : partition.values,
+    });
+  }
+
+  // Most searches fit in a single request, so these are split only once it
+  // hits `max_results`.
+  state->pending_shards = 1;
+  StartShard(state, std::move(root_shard));
+}
+
+// static
+std::vector<PavlovLobbySearcher::Shard> PavlovLobbySearcher::SplitShard(
+    const std::vector<LobbySearchPartition>& partitions,
+    const Shard& shard) {
+  for (size_t idx = 0; idx < partitions.size(); ++idx) {
+    const auto& attribute = shard[idx];
+    if (attribute.exclude_values) {
+      continue;
+    }
+
+    const bool any_value = attribute.values.empty();
+    const auto& values = any_value ? partitions[idx].values : attribute.values;
+    if (values.size() < 2 && !any_value) {
+      continue;
+    }
+
+    std::vector<Shard> shards;
+    const auto chunk_size =
+        (values.size() + kMaxShardsPerSplit - 1) / kMaxShardsPerSplit;
+    for (auto& chunk : util::ToChunks(values, chunk_size)) {
+      shards.push_back(shard);
+      shards.back()[idx] = ShardAttribute{std::move(chunk)};
+    }
+    if (any_value) {
+      shards.push_back(shard);
+      shards.back()[idx] = ShardAttribute{partitions[idx].values, true};
+    }
+    if (shards.size() > 1) {
+      return shards;
+    }
+  }
+  return {};
+}
+
+void PavlovLobbySearcher::StartShard(std::shared_ptr<SearchState> state,
+                                     Shard shard) {
+  ++state->started_shards;
+
+  auto request = state->request;
+  for (size_t idx = 0; idx < shard.size(); ++idx) {
+    if (shard[idx].values.empty()) {
+      continue;
+    }
+    request.criteria.push_back(backend::eos::SearchLobbiesCriteria{
+        state->partitions[idx].key,
+        shard[idx].exclude_values ? backend::eos::CriteriaOperator::NOT_ANY_OF
+                                  : backend::eos::CriteriaOperator::ANY_OF,
+        shard[idx].values,
+    });
+  }
+
+  lobby_backend_->SearchLobbies(
+      std::move(request),
+      base::BindOnce(&PavlovLobbySearcher::OnShardDone, weak_this_, state,
+                     std::move(shard)));
+}
+
+void PavlovLobbySearcher::OnShardDone(
+    std::shared_ptr<SearchState> state,
+    Shard shard,
+    backend::Result result,
+    backend::eos::SearchLobbiesResponse response) {
+  --state->pending_shards;
+
+  if (result.status != backend::Result::Status::kOk) {
+    LOG(WARNING) << __FUNCTION__ << "() lobby search shard failed: "
+                 << result.error;
+    if (!state->first_error) {
+      state->first_error = std::move(result);
+    }
+  } else {
+    ++state->succeeded_shards;
+    state->response.todo_auth_token = std::move(response.todo_auth_token);
+
+    const bool hit_max_results =
+        static_cast<int64_t>(response.sessions.size()) >=
+        state->request.max_results;
+
+    // Lobbies can move between shards while these are searched.
+    for (auto& session : response.sessions) {
+      if (state->lobby_ids.insert(session.id).second) {
+        state->response.sessions.push_back(std::move(session));
+      }
+    }
+
+    if (hit_max_results) {
+      auto shards = SplitShard(state->partitions, shard);
+      if (shards.empty() ||
+          state->started_shards + static_cast<int>(shards.size()) >
+              kMaxShardsPerSearch) {
+        LOG(WARNING) << __FUNCTION__
+                     << "() lobby search shard can't be split any further, "
+                        "some lobbies may be missing";
+      } else {
+        state->pending_shards += static_cast<int>(shards.size());
+        for (auto& child_shard : shards) {
+          StartShard(state, std::move(child_shard));
+        }
+      }
+    }
+  }
+
+  if (state->pending_shards > 0) {
+    return;
+  }
+
+  if (state->succeeded_shards == 0) {
+    std::move(state->callback)
+        .Run(state->first_error.value_or(backend::Result{
+                 backend::Result::Status::kFailed, "Lobby search failed"}),
+             {});
+    return;
+  }
+
+  state->response.count =
+      static_cast<int64_t>(state->response.sessions.size());
+  std::move(state->callback)
+      .Run(backend::Result{backend::Result::Status::kOk, ""},
+           std::move(state->response));
+}
+
+}  // namespace engine::game::pavlov
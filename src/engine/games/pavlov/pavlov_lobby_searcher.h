@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "engine/backends/eos/eos_data.h"
+#include "engine/backends/result.h"
+
+namespace engine::backend {
+class EosLobbyBackend;
+}  // namespace engine::backend
+
+namespace engine::game::pavlov {
+
+// Lobby attribute that searches are split by.
+struct LobbySearchPartition {
+  std::string key;
+  std::vector<std::string> values;
+  // Whether lobbies with values other than `values` match the search as well.
+  bool include_other_values = false;
+};
+
+// Splits EOS lobby searches which hit the `max_results` of a single request
+// into disjoint shards by `LobbySearchPartition`s, all searched in parallel,
+// so that results aren't cut off. Shards which still hit that limit are split
+// further.
+class PavlovLobbySearcher {
+ public:
+  explicit PavlovLobbySearcher(backend::EosLobbyBackend* lobby_backend);
+  ~PavlovLobbySearcher();
+
+  // `request.criteria` are shared by all shards, while `request.max_results`
+  // applies to each of them. Runs `on_done_callback` with lobbies found by all
+  // shards, deduplicated by their id. Fails only if no shard succeeded.
+  void SearchLobbies(
+      backend::eos::SearchLobbiesRequest request,
+      std::vector<LobbySearchPartition> partitions,
+      base::OnceCallback<void(backend::Result,
+                              backend::eos::SearchLobbiesResponse)>
+          on_done_callback);
+
+ private:
+  // Values of a partition's attribute that a shard covers, parallel to the
+  // search's partitions. Empty `values` cover any value.
+  struct ShardAttribute {
+    std::vector<std::string> values;
+    // Whether the shard covers values *other* than `values`.
+    bool exclude_values = false;
+  };
+  using Shard = std::vector<ShardAttribute>;
+
+  struct SearchState;
+
+  static std::vector<Shard> SplitShard(
+      const std::vector<LobbySearchPartition>& partitions,
+      const Shard& shard);
+
+  void StartShard(std::shared_ptr<SearchState> state, Shard shard);
+  void OnShardDone(std::shared_ptr<SearchState> state,
+                   Shard shard,
+                   backend::Result result,
+                   backend::eos::SearchLobbiesResponse response);
+
+  backend::EosLobbyBackend* lobby_backend_;
+
+  base::WeakPtr<PavlovLobbySearcher> weak_this_;
+  base::WeakPtrFactory<PavlovLobbySearcher> weak_factory_;
+};
+
+}  // namespace engine::game::pavlov
@@ -0,0 +1,255 @@
+#include "engine/games/pavlov/pavlov_server_list_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "nlohmann/json.hpp"
+
+namespace engine::game::pavlov {
+
+namespace {
+
+// Fields of a `PavlovServer` which are listed in a `PavlovLobbyServer`.
+enum class ServerField {
+  kIgnored,
+  kName,
+  kSlots,
+  kMaxSlots,
+  kMapId,
+  kMapLabel,
+  kPort,
+  kPasswordProtected,
+  kGameModeLabel,
+  kIp,
+};
+
+ServerField GetServerField(std::string_view key) {
+  if (key == "name")
+    return ServerField::kName;
+  if (key == "slots")
+    return ServerField::kSlots;
+  if (key == "maxSlots")
+    return ServerField::kMaxSlots;
+  if (key == "mapId")
+    return ServerField::kMapId;
+  if (key == "mapLabel")
+    return ServerField::kMapLabel;
+  if (key == "port")
+    return ServerField::kPort;
+  if (key == "bPasswordProtected")
+    return ServerField::kPasswordProtected;
+  if (key == "gameModeLabel")
+    return ServerField::kGameModeLabel;
+  if (key == "ip")
+    return ServerField::kIp;
+  return ServerField::kIgnored;
+}
+
+// Receives events of `nlohmann::json::sax_parse()`. The response is expected
+// to be `{"servers": [{...}, ...], ...}`, everything outside of the server
+// objects' fields listed above is skipped.
+class ServerListSaxHandler {
+ public:
+  using number_integer_t = nlohmann::json::number_integer_t;
+  using number_unsigned_t = nlohmann::json::number_unsigned_t;
+  using number_float_t = nlohmann::json::number_float_t;
+  using string_t = nlohmann::json::string_t;
+  using binary_t = nlohmann::json::binary_t;
+
+  explicit ServerListSaxHandler(std::vector<PavlovLobbyServer>* servers)
+      : servers_(servers) {}
+
+  const std::string& error() const { return error_; }
+
+  bool null() { return OnScalar(); }
+
+  bool boolean(bool value) {
+    if (!IsInServerField()) {
+      return OnScalar();
+    }
+    if (field_ != ServerField::kPasswordProtected) {
+      return Fail();
+    }
+    server_->locked = value;
+    return true;
+  }
+
+  bool number_integer(number_integer_t value) { return OnNumber(value); }
+
+  bool number_unsigned(number_unsigned_t value) {
+    return OnNumber(static_cast<int64_t>(value));
+  }
+
+  bool number_float(number_float_t value, const string_t& /*text*/) {
+    return OnNumber(static_cast<int64_t>(value));
+  }
+
+  bool string(string_t& value) {
+    if (!IsInServerField()) {
+      return OnScalar();
+    }
+    switch (field_) {
+      case ServerField::kName:
+        server_->name_owner = std::move(value);
+        return true;
+      case ServerField::kMapId:
+        server_->map = std::move(value);
+        return true;
+      case ServerField::kMapLabel:
+        server_->map_label = std::move(value);
+        return true;
+      case ServerField::kGameModeLabel:
+        server_->gamemode = std::move(value);
+        return true;
+      case ServerField::kIp:
+        server_->ip = std::move(value);
+        return true;
+      default:
+        return Fail();
+    }
+  }
+
+  bool binary(binary_t& /*value*/) { return OnScalar(); }
+
+  bool start_object(std::size_t /*elements*/) {
+    if (depth_ == kServerDepth && in_servers_) {
+      server_ = StartServer();
+    } else if (depth_ != 0 && !IsIgnoredValue()) {
+      return Fail();
+    }
+    ++depth_;
+    return true;
+  }
+
+  bool end_object() {
+    --depth_;
+    if (depth_ == kServerDepth && in_servers_) {
+      server_->id = server_->ip + ":" + std::to_string(server_->port);
+      servers_->push_back(std::move(*server_));
+      server_.reset();
+    }
+    return true;
+  }
+
+  bool start_array(std::size_t /*elements*/) {
+    if (depth_ == 1 && in_servers_key_) {
+      in_servers_ = true;
+    } else if (!IsIgnoredValue()) {
+      return Fail();
+    }
+    ++depth_;
+    return true;
+  }
+
+  bool end_array() {
+    --depth_;
+    if (depth_ == 1) {
+      in_servers_ = false;
+    }
+    return true;
+  }
+
+  bool key(string_t& key) {
+    if (depth_ == 1) {
+      in_servers_key_ = (key == "servers");
+    } else if (depth_ == kServerDepth + 1 && server_) {
+      field_ = GetServerField(key);
+    }
+    return true;
+  }
+
+  bool parse_error(std::size_t /*position*/,
+                   const std::string& /*last_token*/,
+                   const nlohmann::json::exception& e) {
+    error_ = e.what();
+    return false;
+  }
+
+ private:
+  // Depth of the `servers` array's elements.
+  static constexpr int kServerDepth = 2;
+
+  static PavlovLobbyServer StartServer() {
+    PavlovLobbyServer server;
+    server.players = -1;
+    server.max_players = -1;
+    server.crossplatform = false;  // PC servers are not crossplatform
+    server.locked = false;
+    server.platform = PavlovPlatform::kPCVR;
+    server.region = "?ms";
+    server.port = -1;
+    return server;
+  }
+
+  bool IsInServerField() const {
+    return server_ && depth_ == kServerDepth + 1 &&
+           field_ != ServerField::kIgnored;
+  }
+
+  // Whether a value starting at the current position isn't needed.
+  bool IsIgnoredValue() const {
+    if (depth_ == 0) {
+      return false;  // The response itself must be an object.
+    }
+    if (depth_ == 1) {
+      return !in_servers_key_;
+    }
+    if (depth_ == kServerDepth && in_servers_) {
+      return false;  // Servers must be objects.
+    }
+    return !IsInServerField();
+  }
+
+  bool OnScalar() { return IsIgnoredValue() || Fail(); }
+
+  bool OnNumber(int64_t value) {
+    if (!IsInServerField()) {
+      return OnScalar();
+    }
+    switch (field_) {
+      case ServerField::kSlots:
+        server_->players = value;
+        return true;
+      case ServerField::kMaxSlots:
+        server_->max_players = value;
+        return true;
+      case ServerField::kPort:
+        server_->port = value;
+        return true;
+      default:
+        return Fail();
+    }
+  }
+
+  bool Fail() {
+    error_ = "unexpected value at depth " + std::to_string(depth_);
+    return false;
+  }
+
+  std::vector<PavlovLobbyServer>* servers_;
+  std::string error_;
+  int depth_ = 0;
+  // Whether the last top-level key was `servers`.
+  bool in_servers_key_ = false;
+  bool in_servers_ = false;
+  std::optional<PavlovLobbyServer> server_;
+  ServerField field_ = ServerField::kIgnored;
+};
+
+}  // namespace
+
+bool ParseServerListResponse(std::span<const uint8_t> data,
+                             std::vector<PavlovLobbyServer>* servers,
+                             std::string* error) {
+  ServerListSaxHandler handler(servers);
+  if (!nlohmann::json::sax_parse(data.begin(), data.end(), &handler)) {
+    *error = handler.error();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace engine::game::pavlov
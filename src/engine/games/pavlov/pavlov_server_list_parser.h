@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "engine/games/pavlov/pavlov_data.h"
+
+namespace engine::game::pavlov {
+
+// Parses the master server's list response in a single streaming pass,
+// building `servers` directly from it without an intermediate JSON document.
+// Unknown fields are skipped. Returns false and sets `error` if `data` isn't a
+// valid server list.
+bool ParseServerListResponse(std::span<const uint8_t> data,
+                             std::vector<PavlovLobbyServer>* servers,
+                             std::string* error);
+
+}  // namespace engine::game::pavlov
@@ -0,0 +1,126 @@
+#include "engine/games/pavlov/pavlov_server_pinger.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "base/net/resource_request.h"
+#include "base/net/simple_url_loader.h"
+
+namespace engine::game::pavlov {
+
+namespace {
+const auto kResponseMaxSize = 16 * 1024;
+}  // namespace
+
+PavlovServerPinger::PavlovServerPinger()
+    : rtt_prober_(backend::RttProber::Create()), weak_factory_(this) {
+  weak_this_ = weak_factory_.GetWeakPtr();
+}
+
+PavlovServerPinger::~PavlovServerPinger() = default;
+
+void PavlovServerPinger::PingServers(std::vector<Target> targets,
+                                     size_t max_in_flight,
+                                     base::TimeDelta timeout,
+                                     PingCallback on_ping_callback,
+                                     base::OnceClosure on_done_callback) {
+  ++session_id_;
+  auto previous_on_done_callback = std::move(on_done_callback_);
+
+  queued_targets_.assign(std::make_move_iterator(targets.begin()),
+                         std::make_move_iterator(targets.end()));
+  in_flight_ = 0;
+  max_in_flight_ = std::max<size_t>(max_in_flight, 1);
+  timeout_ = timeout;
+  on_ping_callback_ = std::move(on_ping_callback);
+  on_done_callback_ = std::move(on_done_callback);
+
+  if (previous_on_done_callback) {
+    std::move(previous_on_done_callback).Run();
+  }
+  StartQueuedPings();
+}
+
+void PavlovServerPinger::StartQueuedPings() {
+  if (queued_targets_.empty() && in_flight_ == 0) {
+    if (on_done_callback_) {
+      std::move(on_done_callback_).Run();
+    }
+    return;
+  }
+
+  while (!queued_targets_.empty() && in_flight_ < max_in_flight_) {
+    auto target = std::move(queued_targets_.front());
+    queued_targets_.pop_front();
+    ++in_flight_;
+
+    const auto address = target.address;
+    rtt_prober_->Probe(
+        backend::RttProbeRequest{address,
+                                 backend::RttProbeProtocol::kTcpConnect,
+                                 "",
+                                 timeout_},
+        base::BindOnce(&PavlovServerPinger::OnRttProbeDone, weak_this_,
+                       session_id_, std::move(target)));
+  }
+}
+
+void PavlovServerPinger::OnRttProbeDone(int session_id,
+                                        Target target,
+                                        backend::RttProbeResult result) {
+  if (session_id != session_id_) {
+    return;
+  }
+
+  switch (result.status) {
+    case backend::RttProbeResult::Status::kOk:
+      OnPingDone(session_id, std::move(target.id), result.rtt);
+      return;
+    case backend::RttProbeResult::Status::kFailed:
+    case backend::RttProbeResult::Status::kTimedOut:
+      OnPingDone(session_id, std::move(target.id), std::nullopt);
+      return;
+    case backend::RttProbeResult::Status::kNotStarted:
+      // The HTTP stack resolves host names and opens its own sockets, so it
+      // may still get through.
+      break;
+  }
+
+  base::net::SimpleUrlLoader::DownloadLimited(
+      base::net::ResourceRequest{target.address}
+          .WithFollowRedirects(false)
+          .WithHeadersOnly()
+          .WithTimeout(timeout_),
+      kResponseMaxSize,
+      base::BindOnce(&PavlovServerPinger::OnPingResponse, weak_this_,
+                     session_id, std::move(target.id)));
+}
+
+void PavlovServerPinger::OnPingResponse(int session_id,
+                                        std::string id,
+                                        base::net::ResourceResponse response) {
+  std::optional<base::TimeDelta> ping;
+  if (response.result == base::net::Result::kOk) {
+    ping = response.timing_connect - response.timing_queue;
+  }
+  OnPingDone(session_id, std::move(id), ping);
+}
+
+void PavlovServerPinger::OnPingDone(int session_id,
+                                    std::string id,
+                                    std::optional<base::TimeDelta> ping) {
+  if (session_id != session_id_) {
+    return;
+  }
+  --in_flight_;
+
+  on_ping_callback_.Run(std::move(id), ping);
+
+  // The callback may have started new pings already.
+  if (session_id != session_id_) {
+    return;
+  }
+  StartQueuedPings();
+}
+
+}  // namespace engine::game::pavlov
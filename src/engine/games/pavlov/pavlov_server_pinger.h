@@ -0,0 +1,71 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/memory/weak_ptr.h"
+#include "base/net/resource_response.h"
+#include "base/time/time_delta.h"
+#include "engine/backends/rtt/rtt_prober.h"
+
+namespace engine::game::pavlov {
+
+// Measures pings of Pavlov servers as the time of a TCP handshake with their
+// game port, falling back to HEAD requests only if the handshake couldn't be
+// attempted at all. At most `max_in_flight` servers are pinged at once, so
+// that these don't queue up behind each other and inflate the measured times.
+class PavlovServerPinger {
+ public:
+  struct Target {
+    std::string id;
+    std::string address;  // IP:Port
+  };
+
+  // `ping` is empty if the server didn't respond in time.
+  using PingCallback = base::RepeatingCallback<
+      void(std::string id, std::optional<base::TimeDelta> ping)>;
+
+  PavlovServerPinger();
+  ~PavlovServerPinger();
+
+  // Each request times out `timeout` after it's started, not counting the
+  // time spent waiting in the queue. Replaces the previous call's pings:
+  // queued ones are dropped, results of those in flight are ignored and its
+  // `on_done_callback` runs right away.
+  void PingServers(std::vector<Target> targets,
+                   size_t max_in_flight,
+                   base::TimeDelta timeout,
+                   PingCallback on_ping_callback,
+                   base::OnceClosure on_done_callback);
+
+ private:
+  void StartQueuedPings();
+  void OnRttProbeDone(int session_id,
+                      Target target,
+                      backend::RttProbeResult result);
+  void OnPingResponse(int session_id,
+                      std::string id,
+                      base::net::ResourceResponse response);
+  void OnPingDone(int session_id,
+                  std::string id,
+                  std::optional<base::TimeDelta> ping);
+
+  std::unique_ptr<backend::RttProber> rtt_prober_;
+
+  int session_id_ = 0;
+  std::deque<Target> queued_targets_;
+  size_t in_flight_ = 0;
+  size_t max_in_flight_ = 1;
+  base::TimeDelta timeout_;
+  PingCallback on_ping_callback_;
+  base::OnceClosure on_done_callback_;
+
+  base::WeakPtr<PavlovServerPinger> weak_this_;
+  base::WeakPtrFactory<PavlovServerPinger> weak_factory_;
+};
+
+}  // namespace engine::game::pavlov
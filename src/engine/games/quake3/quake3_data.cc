@@ -95,12 +95,22 @@ void to_json(nlohmann::json& out, const Quake3Config& obj) {
   out = nlohmann::json{
       {"filters", obj.filters},
       {"executable_path", obj.executable_path},
+      {"probes_per_second", obj.probes_per_second},
+      {"max_in_flight_probes", obj.max_in_flight_probes},
+      {"refresh_query", obj.refresh_query},
+      {"receive_threads", obj.receive_threads},
+      {"ping_samples", obj.ping_samples},
   };
 }
 
 void from_json(const nlohmann::json& in, Quake3Config& obj) {
   obj.filters = in.value("filters", Quake3Filters{});
   obj.executable_path = in.value("executable_path", "");
+  obj.probes_per_second = in.value("probes_per_second", 500);
+  obj.max_in_flight_probes = in.value("max_in_flight_probes", 250);
+  obj.refresh_query = in.value("refresh_query", "getstatus");
+  obj.receive_threads = in.value("receive_threads", 1);
+  obj.ping_samples = in.value("ping_samples", 0);
 }
 
 model::GameFilters ToModel(const Quake3Filters& filters) {
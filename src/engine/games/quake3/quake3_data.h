@@ -55,6 +55,12 @@ struct Quake3Filters {
 struct Quake3Config {
   Quake3Filters filters;
   std::string executable_path;
+  int probes_per_second = 500;
+  int max_in_flight_probes = 250;
+  // "getstatus" or "getinfo"
+  std::string refresh_query = "getstatus";
+  int receive_threads = 1;
+  int ping_samples = 0;
 };
 
 struct Quake3Server {
@@ -2,13 +2,20 @@
 
 #include <algorithm>
 #include <atomic>
-#include <map>
+#include <chrono>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 
 #include "base/bind_post_task.h"
 #include "base/logging.h"
+#include "base/time/time_delta.h"
+
+#include "engine/backends/rtt/rtt_cache.h"
 
 #include <windows.h>
 
@@ -72,7 +79,7 @@ model::GameSearchResults FilterModelResultsFunction(
   model::GameSearchResults filtered_results;
   for (const auto& result : unfiltered_results.lobbies) {
     // result_fields: Address (0), Game Mode (1), Hostname (2), Map (3), Players
-    // (4), Humans (5), Ping (6)
+    // (4), Humans (5), Ping (6), Min Ping (7), Jitter (8)
     if (result.result_fields.size() >= 7) {
       // 1. Game Mode Filter
       if (!all_modes) {
@@ -114,20 +121,6 @@ model::GameSearchResults FilterModelResultsFunction(
   return filtered_results;
 }
 
-struct GroupKey {
-  std::string hostname;
-  std::string map;
-  std::string game_type;
-  int players;
-  int max_players;
-
-  bool operator<(const GroupKey& other) const {
-    return std::tie(hostname, map, game_type, players, max_players) <
-           std::tie(other.hostname, other.map, other.game_type, other.players,
-                    other.max_players);
-  }
-};
-
 bool AreMembersSame(const std::vector<backend::Quake3ServerResult::Member>& a,
                     const std::vector<backend::Quake3ServerResult::Member>& b) {
   if (a.size() != b.size())
@@ -149,6 +142,18 @@ bool AreMembersSame(const std::vector<backend::Quake3ServerResult::Member>& a,
   return get_canonical(a) == get_canonical(b);
 }
 
+// Returns `fallback` if `value` isn't a number.
+int ParseConfigNumber(const std::string& value,
+                      int fallback,
+                      int min_value,
+                      int max_value) {
+  try {
+    return std::clamp(std::stoi(value), min_value, max_value);
+  } catch (...) {
+    return fallback;
+  }
+}
+
 int GetPortFromAddress(const std::string& address) {
   size_t colon_pos = address.find_last_of(':');
   if (colon_pos == std::string::npos)
@@ -160,14 +165,198 @@ int GetPortFromAddress(const std::string& address) {
   }
 }
 
+uint64_t MixHash(uint64_t value) {
+  // SplitMix64 finalizer
+  value ^= value >> 30;
+  value *= 0xBF58476D1CE4E5B9ULL;
+  value ^= value >> 27;
+  value *= 0x94D049BB133111EBULL;
+  value ^= value >> 31;
+  return value;
+}
+
+uint64_t CombineHash(uint64_t seed, uint64_t value) {
+  return MixHash(seed ^ (value + 0x9E3779B97F4A7C15ULL));
+}
+
+// Equal for servers that look the same in the results list. Member names are
+// summed, so that their order doesn't matter.
+uint64_t GetServerFingerprint(const backend::Quake3ServerResult& server) {
+  const std::hash<std::string> string_hash;
+
+  uint64_t members_hash = 0;
+  for (const auto& member : server.members) {
+    members_hash += MixHash(string_hash(member.name));
+  }
+
+  uint64_t fingerprint = string_hash(server.hostname);
+  fingerprint = CombineHash(fingerprint, string_hash(server.map));
+  fingerprint = CombineHash(fingerprint, string_hash(server.game_type));
+  fingerprint = CombineHash(fingerprint, server.players);
+  fingerprint = CombineHash(fingerprint, server.max_players);
+  fingerprint = CombineHash(fingerprint, server.members.size());
+  return CombineHash(fingerprint, members_hash);
+}
+
+bool AreServersSame(const backend::Quake3ServerResult& a,
+                    const backend::Quake3ServerResult& b) {
+  return std::tie(a.hostname, a.map, a.game_type, a.players, a.max_players) ==
+             std::tie(b.hostname, b.map, b.game_type, b.players,
+                      b.max_players) &&
+         AreMembersSame(a.members, b.members);
+}
+
+// Removes mirrored servers (same hostname, map, mode, player counts and member
+// names), keeping the one with the lowest port.
+std::vector<backend::Quake3ServerResult> DeduplicateServers(
+    std::vector<backend::Quake3ServerResult> servers) {
+  // Fingerprint to indices of `unique_servers`. Fingerprints of different
+  // servers may collide, so those are still compared field by field.
+  std::unordered_multimap<uint64_t, size_t> fingerprints;
+  fingerprints.reserve(servers.size());
+
+  std::vector<backend::Quake3ServerResult> unique_servers;
+  unique_servers.reserve(servers.size());
+
+  for (auto& server : servers) {
+    const uint64_t fingerprint = GetServerFingerprint(server);
+
+    bool is_duplicate = false;
+    auto [it, end] = fingerprints.equal_range(fingerprint);
+    for (; it != end; ++it) {
+      auto& existing = unique_servers[it->second];
+      if (AreServersSame(server, existing)) {
+        is_duplicate = true;
+        // Keep the one with the lowest port
+        if (GetPortFromAddress(server.address) <
+            GetPortFromAddress(existing.address)) {
+          existing = std::move(server);
+        }
+        break;
+      }
+    }
+
+    if (!is_duplicate) {
+      fingerprints.emplace(fingerprint, unique_servers.size());
+      unique_servers.push_back(std::move(server));
+    }
+  }
+
+  return unique_servers;
+}
+
+// Also sorts `server` members for presentation.
+model::GameServerLobbyResult ToModelResult(
+    backend::Quake3ServerResult& server) {
+  // Sort players: humans first, then bots. Within each group, sort by name
+  // ASC.
+  std::sort(server.members.begin(), server.members.end(),
+            [](const auto& a, const auto& b) {
+              bool a_is_bot = (a.ping == 0);
+              bool b_is_bot = (b.ping == 0);
+              if (a_is_bot != b_is_bot) {
+                return !a_is_bot;  // Human (not bot) comes first
+              }
+              return a.name < b.name;
+            });
+
+  const std::string humans =
+      server.humans ? std::to_string(*server.humans) : std::string("?");
+
+  model::GameServerLobbyResult entry;
+  entry.result_fields = {
+      server.address,
+      server.game_type,
+      server.hostname,
+      server.map,
+      std::to_string(server.players) + "/" + std::to_string(server.max_players),
+      humans + "/" + std::to_string(server.max_players),
+      std::to_string(server.ping),
+      server.min_ping ? std::to_string(*server.min_ping) : std::string(),
+      server.ping_jitter ? std::to_string(*server.ping_jitter)
+                         : std::string()};
+  entry.metadata = server.metadata;
+  return entry;
+}
+
+std::string FormatCacheAge(std::chrono::system_clock::time_point timestamp) {
+  const auto minutes = std::chrono::duration_cast<std::chrono::minutes>(
+                           std::chrono::system_clock::now() - timestamp)
+                           .count();
+  if (minutes < 1)
+    return "less than a minute ago";
+  if (minutes < 120)
+    return std::to_string(minutes) + " minutes ago";
+  if (minutes < 48 * 60)
+    return std::to_string(minutes / 60) + " hours ago";
+  return std::to_string(minutes / (24 * 60)) + " days ago";
+}
+
+model::SearchDetailsResponse ToDetailsResponse(
+    const backend::Quake3ServerResult& server) {
+  model::SearchDetailsResponse response{true, {}};
+  for (const auto& member : server.members) {
+    model::SearchDetailsResponse::Member m;
+    m.id = member.name;
+    m.name = member.name;
+    m.avatar_url = "";  // Generic placeholder used in UI
+    m.user_data.push_back({"Score", std::to_string(member.score)});
+    m.user_data.push_back({"Ping", std::to_string(member.ping)});
+    m.user_data.push_back({"IsBot", (member.ping == 0 ? "true" : "false")});
+    response.members.push_back(std::move(m));
+  }
+  return response;
+}
+
+// Widening filters takes effect only after the next search, as servers
+// filtered out by masters aren't known until then.
+backend::Quake3MasterFilters GetMasterFilters(
+    const quake3::Quake3Filters& filters) {
+  backend::Quake3MasterFilters master_filters;
+  master_filters.include_empty = !filters.others.hide_empty;
+  master_filters.include_full = !filters.others.hide_full;
+
+  if (!filters.game_modes.all) {
+    // Values of `g_gametype`, see `MapGameType()` in the backend.
+    const std::pair<bool, int> game_types[] = {
+        {filters.game_modes.ffa, 0},
+        {filters.game_modes.tournament, 1},
+        {filters.game_modes.single, 2},
+        {filters.game_modes.tdm, 3},
+        {filters.game_modes.ctf, 4},
+        {filters.game_modes.one_flag_ctf, 5},
+        {filters.game_modes.overload, 6},
+        {filters.game_modes.harvester, 7},
+        {filters.game_modes.team_ffa, 8},
+    };
+    for (const auto& [enabled, game_type] : game_types) {
+      if (enabled)
+        master_filters.game_types.push_back(game_type);
+    }
+  }
+
+  return master_filters;
+}
+
+std::optional<backend::Quake3ServerQuery> ParseRefreshQuery(
+    const std::string& value) {
+  if (value == "getstatus")
+    return backend::Quake3ServerQuery::kStatus;
+  if (value == "getinfo")
+    return backend::Quake3ServerQuery::kInfo;
+  return std::nullopt;
+}
+
 }  // namespace
 
 Quake3Game::Quake3Game(SetStatusTextCallback set_status_text,
                        ReportMessageCallback report_message,
-                       nlohmann::json game_config)
+                       nlohmann::json game_config,
+                       backend::RttCache* rtt_cache)
     : BaseGame(std::move(set_status_text), std::move(report_message)),
       config_(),
       master_backend_(nullptr),
+      rtt_cache_(rtt_cache),
       weak_factory_(this) {
   weak_this_ = weak_factory_.GetWeakPtr();
 
@@ -202,6 +391,12 @@ Quake3Game::Quake3Game(SetStatusTextCallback set_status_text,
       config_.filters.game_modes = loaded_config.filters.game_modes;
       config_.filters.pings = loaded_config.filters.pings;
       config_.executable_path = std::move(loaded_config.executable_path);
+      config_.probes_per_second = loaded_config.probes_per_second;
+      config_.max_in_flight_probes = loaded_config.max_in_flight_probes;
+      if (ParseRefreshQuery(loaded_config.refresh_query))
+        config_.refresh_query = std::move(loaded_config.refresh_query);
+      config_.receive_threads = loaded_config.receive_threads;
+      config_.ping_samples = loaded_config.ping_samples;
     } catch (const std::exception& e) {
       LOG(ERROR) << __FUNCTION__
                  << "() failed to load game config: " << e.what();
@@ -209,6 +404,9 @@ Quake3Game::Quake3Game(SetStatusTextCallback set_status_text,
   }
 
   master_backend_ = backend::Quake3MasterBackend::Create();
+  ApplyProbeSettings();
+
+  cached_servers_ = servers_cache_.Load();
 }
 
 Quake3Game::~Quake3Game() = default;
@@ -279,6 +477,21 @@ model::Game Quake3Game::GetModel() const {
                   model::GameResultsColumnAlignment::kRight,
                   model::GameResultsColumnOrdering::kNumber,
               },
+              // Empty for servers that weren't sent ping samples.
+              model::GameResultsColumnFormat{
+                  "Min Ping",
+                  true,
+                  65,
+                  model::GameResultsColumnAlignment::kRight,
+                  model::GameResultsColumnOrdering::kPingOrString,
+              },
+              model::GameResultsColumnFormat{
+                  "Jitter",
+                  true,
+                  50,
+                  model::GameResultsColumnAlignment::kRight,
+                  model::GameResultsColumnOrdering::kPingOrString,
+              },
           },
           {
               model::GameResultsColumnFormat{
@@ -452,10 +665,44 @@ void Quake3Game::SearchLobbiesAndServers(
     return;
   }
 
+  base::RepeatingCallback<void(std::vector<backend::Quake3ServerResult>)>
+      partial_results_callback;
+  auto known_servers = GetKnownServers();
+  std::shared_ptr<PartialResultsState> state;
+  const int search_id = ++last_search_id_;
+  if (request.partial_results_callback) {
+    state = std::make_shared<PartialResultsState>();
+    state->search_id = search_id;
+    partial_results_callback = base::BindToCurrentSequence(
+        base::BindRepeating(&Quake3Game::OnPartialServersReceived, weak_this_,
+                            state,
+                            std::move(request.partial_results_callback)),
+        FROM_HERE);
+
+    // Show servers from the previous session right away, while the refresh
+    // revalidates them.
+    if (cached_servers_ && !cached_servers_->servers.empty()) {
+      state->stale_servers = std::move(cached_servers_->servers);
+      state->stale_count = state->stale_servers.size();
+      for (auto& server : state->stale_servers) {
+        server.metadata["stale"] = "true";
+      }
+      SetStatusText(std::string("Showing ") +
+                    std::to_string(state->stale_servers.size()) +
+                    " cached Quake 3 servers from " +
+                    FormatCacheAge(cached_servers_->timestamp) +
+                    ", refreshing...");
+      partial_results_callback.Run({});
+    }
+  }
+  cached_servers_.reset();
+
   master_backend_->SearchServers(
-      enabled_masters,
+      enabled_masters, GetMasterFilters(config_.filters), known_servers,
+      std::move(partial_results_callback),
       base::BindToCurrentSequence(
           base::BindOnce(&Quake3Game::OnMasterSearchDone, weak_this_,
+                         search_id, std::move(state),
                          std::move(on_done_callback),
                          std::move(request.players_callback)),
           FROM_HERE));
@@ -471,18 +718,18 @@ void Quake3Game::GetServerLobbyDetails(
 
   for (const auto& server : *last_response_results_) {
     if (server.address == request.result_id) {
-      model::SearchDetailsResponse response{true, {}};
-      for (const auto& member : server.members) {
-        model::SearchDetailsResponse::Member m;
-        m.id = member.name;
-        m.name = member.name;
-        m.avatar_url = "";  // Generic placeholder used in UI
-        m.user_data.push_back({"Score", std::to_string(member.score)});
-        m.user_data.push_back({"Ping", std::to_string(member.ping)});
-        m.user_data.push_back({"IsBot", (member.ping == 0 ? "true" : "false")});
-        response.members.push_back(std::move(m));
+      if (server.has_members || !master_backend_) {
+        std::move(on_done_callback).Run(ToDetailsResponse(server));
+        return;
       }
-      std::move(on_done_callback).Run(std::move(response));
+
+      // Listed with `getinfo`, so players need to be queried now.
+      master_backend_->GetServerDetails(
+          server.address,
+          base::BindToCurrentSequence(
+              base::BindOnce(&Quake3Game::OnServerStatusReceived, weak_this_,
+                             std::move(on_done_callback)),
+              FROM_HERE));
       return;
     }
   }
@@ -533,12 +780,85 @@ model::GameConfigDescriptor Quake3Game::GetConfigDescriptor() const {
   master_servers.options.push_back(std::move(masters));
   descriptor.sections.push_back(std::move(master_servers));
 
+  // Network tab
+  model::GameConfigSection network;
+  network.name = "Network";
+  network.options.push_back({
+      "probes_per_second",
+      "Server queries per second",
+      "Lower this if servers are missing or pings are too high after refresh",
+      model::GameConfigOptionType::kString,
+      std::to_string(config_.probes_per_second),
+      {},  // list_columns
+      {},  // list_items
+  });
+  network.options.push_back({
+      "refresh_query",
+      "Server query used for refresh",
+      "'getstatus' lists players of every server, 'getinfo' uses less "
+      "bandwidth and queries players only when server details are opened",
+      model::GameConfigOptionType::kString,
+      config_.refresh_query,
+      {},  // list_columns
+      {},  // list_items
+  });
+  network.options.push_back({
+      "max_in_flight_probes",
+      "Max pending server queries",
+      "Maximum number of servers queried at the same time",
+      model::GameConfigOptionType::kString,
+      std::to_string(config_.max_in_flight_probes),
+      {},  // list_columns
+      {},  // list_items
+  });
+  network.options.push_back({
+      "receive_threads",
+      "Server query threads",
+      "Number of threads receiving server replies (1-8), raise this only if "
+      "refreshing thousands of servers is slow",
+      model::GameConfigOptionType::kString,
+      std::to_string(config_.receive_threads),
+      {},  // list_columns
+      {},  // list_items
+  });
+  network.options.push_back({
+      "ping_samples",
+      "Ping samples per server",
+      "Number of extra pings (0-5) sent to each server after refresh, for "
+      "more accurate pings at the cost of slightly slower refreshes",
+      model::GameConfigOptionType::kString,
+      std::to_string(config_.ping_samples),
+      {},  // list_columns
+      {},  // list_items
+  });
+  descriptor.sections.push_back(std::move(network));
+
   return descriptor;
 }
 
 void Quake3Game::UpdateConfigOption(std::string key, std::string value) {
   if (key == "executable_path") {
     config_.executable_path = std::move(value);
+  } else if (key == "probes_per_second") {
+    config_.probes_per_second =
+        ParseConfigNumber(value, config_.probes_per_second, 10, 10000);
+    ApplyProbeSettings();
+  } else if (key == "max_in_flight_probes") {
+    config_.max_in_flight_probes =
+        ParseConfigNumber(value, config_.max_in_flight_probes, 1, 4000);
+    ApplyProbeSettings();
+  } else if (key == "refresh_query") {
+    if (ParseRefreshQuery(value)) {
+      config_.refresh_query = std::move(value);
+      ApplyProbeSettings();
+    }
+  } else if (key == "receive_threads") {
+    config_.receive_threads =
+        ParseConfigNumber(value, config_.receive_threads, 1, 8);
+    ApplyProbeSettings();
+  } else if (key == "ping_samples") {
+    config_.ping_samples = ParseConfigNumber(value, config_.ping_samples, 0, 5);
+    ApplyProbeSettings();
   }
 }
 
@@ -576,6 +896,21 @@ bool Quake3Game::CommitConfig(model::GameConfigDescriptor descriptor) {
     for (const auto& option : section.options) {
       if (option.key == "executable_path") {
         config_.executable_path = option.value;
+      } else if (option.key == "probes_per_second") {
+        config_.probes_per_second = ParseConfigNumber(
+            option.value, config_.probes_per_second, 10, 10000);
+      } else if (option.key == "max_in_flight_probes") {
+        config_.max_in_flight_probes = ParseConfigNumber(
+            option.value, config_.max_in_flight_probes, 1, 4000);
+      } else if (option.key == "refresh_query") {
+        if (ParseRefreshQuery(option.value))
+          config_.refresh_query = option.value;
+      } else if (option.key == "receive_threads") {
+        config_.receive_threads =
+            ParseConfigNumber(option.value, config_.receive_threads, 1, 8);
+      } else if (option.key == "ping_samples") {
+        config_.ping_samples =
+            ParseConfigNumber(option.value, config_.ping_samples, 0, 5);
       } else if (option.key == "master_servers") {
         // Clear non-built-in and rebuild from items
         auto old_servers = config_.filters.master_servers;
@@ -620,6 +955,7 @@ bool Quake3Game::CommitConfig(model::GameConfigDescriptor descriptor) {
     }
   }
 
+  ApplyProbeSettings();
   return needs_reinit;
 }
 
@@ -652,87 +988,267 @@ void Quake3Game::LaunchGame(std::string server_address) {
   }
 }
 
-void Quake3Game::OnMasterSearchDone(
-    base::OnceCallback<void(model::SearchResponse)> on_done_callback,
-    base::OnceCallback<void(model::GamePlayersResults)> players_callback,
-    backend::Quake3MasterSearchResponse response) {
-  if (response.result.status != backend::Result::Status::kOk) {
-    std::move(on_done_callback)
-        .Run(model::SearchResponse{
-            model::SearchResult::kError, response.result.error, {}, {}});
+void Quake3Game::ApplyProbeSettings() {
+  if (!master_backend_)
     return;
-  }
 
-  std::map<GroupKey, std::vector<backend::Quake3ServerResult>> grouped_servers;
+  master_backend_->SetProbeSettings(backend::Quake3ProbeSettings{
+      config_.probes_per_second,
+      config_.max_in_flight_probes,
+      ParseRefreshQuery(config_.refresh_query)
+          .value_or(backend::Quake3ServerQuery::kStatus),
+      config_.receive_threads,
+      config_.ping_samples,
+  });
+}
 
-  for (auto& server : response.servers) {
-    GroupKey key{server.hostname, server.map, server.game_type, server.players,
-                 server.max_players};
-    auto& group = grouped_servers[key];
+void Quake3Game::OnServerStatusReceived(
+    base::OnceCallback<void(model::SearchDetailsResponse)> on_done_callback,
+    std::optional<backend::Quake3ServerResult> server) {
+  if (!server) {
+    std::move(on_done_callback).Run({});
+    return;
+  }
 
-    bool is_duplicate = false;
-    for (auto& existing : group) {
-      if (AreMembersSame(server.members, existing.members)) {
-        is_duplicate = true;
-        // Keep the one with the lowest port
-        if (GetPortFromAddress(server.address) <
-            GetPortFromAddress(existing.address)) {
-          existing = std::move(server);
-        }
+  // Remember players, so that reopening the details doesn't query again.
+  if (last_response_results_) {
+    for (auto& listed_server : *last_response_results_) {
+      if (listed_server.address == server->address) {
+        listed_server.humans = server->humans;
+        listed_server.has_members = true;
+        listed_server.members = server->members;
         break;
       }
     }
+  }
 
-    if (!is_duplicate) {
-      group.push_back(std::move(server));
+  std::move(on_done_callback).Run(ToDetailsResponse(*server));
+}
+
+std::vector<backend::Quake3KnownServer> Quake3Game::GetKnownServers() const {
+  // Servers that replied to the previous refresh, or were cached by the
+  // previous session before the first one.
+  const std::vector<backend::Quake3ServerResult>* servers = nullptr;
+  if (last_response_results_) {
+    servers = &*last_response_results_;
+  } else if (cached_servers_) {
+    servers = &cached_servers_->servers;
+  } else {
+    return {};
+  }
+
+  std::vector<backend::Quake3KnownServer> known_servers;
+  known_servers.reserve(servers->size());
+  for (const auto& server : *servers) {
+    const auto rtt = rtt_cache_->Get(server.address);
+    known_servers.push_back(backend::Quake3KnownServer{
+        server.address,
+        rtt_cache_->IsFresh(server.address),
+        rtt ? std::optional<int>(rtt->InMilliseconds()) : std::nullopt,
+    });
+  }
+  return known_servers;
+}
+
+void Quake3Game::SmoothPings(
+    std::vector<backend::Quake3ServerResult>& servers,
+    std::unordered_set<std::string>* smoothed_addresses) {
+  // Every measurement is folded into the cache, and the smoothed value is
+  // shown instead of the noisier round trip time of this refresh alone.
+  for (auto& server : servers) {
+    if (smoothed_addresses &&
+        !smoothed_addresses->insert(server.address).second) {
+      server.ping = rtt_cache_->Get(server.address)->InMilliseconds();
+      continue;
     }
+    server.ping = rtt_cache_
+                      ->AddSample(server.address,
+                                  base::Milliseconds(server.ping))
+                      .InMilliseconds();
   }
+}
 
-  std::vector<backend::Quake3ServerResult> cached_results;
-  model::SearchResponse model_response;
-  model_response.result = model::SearchResult::kOk;
+void Quake3Game::StartListingServers(PartialResultsState& state) {
+  state.listing_started = true;
+  state.listed_servers.clear();
+  state.listed_results.clear();
+  state.listed_fingerprints.clear();
+  state.listed_addresses.clear();
+  last_response_results_.emplace();
+
+  auto stale_servers = std::move(state.stale_servers);
+  state.stale_servers.clear();
+  for (auto& server : stale_servers) {
+    ListServer(state, std::move(server), /*stale=*/true);
+  }
+}
 
-  for (auto& pair : grouped_servers) {
-    for (auto& server : pair.second) {
-      // Sort players: humans first, then bots. Within each group, sort by name
-      // ASC.
-      std::sort(server.members.begin(), server.members.end(),
-                [](const auto& a, const auto& b) {
-                  bool a_is_bot = (a.ping == 0);
-                  bool b_is_bot = (b.ping == 0);
-                  if (a_is_bot != b_is_bot) {
-                    return !a_is_bot;  // Human (not bot) comes first
-                  }
-                  return a.name < b.name;
-                });
+void Quake3Game::ListServer(PartialResultsState& state,
+                            backend::Quake3ServerResult server,
+                            bool stale) {
+  auto& servers = *last_response_results_;
 
-      int humans = 0;
-      for (const auto& member : server.members) {
-        if (member.ping > 0)
-          humans++;
+  // A newer reply (or a refresh of a stale server) replaces the listed one.
+  if (auto it = state.listed_addresses.find(server.address);
+      it != state.listed_addresses.end()) {
+    UnlistServer(state, it->second);
+  }
+
+  const uint64_t fingerprint = GetServerFingerprint(server);
+  auto [it, end] = state.listed_fingerprints.equal_range(fingerprint);
+  for (; it != end; ++it) {
+    const size_t index = it->second;
+    if (!AreServersSame(server, servers[index])) {
+      continue;
+    }
+
+    // Of mirrored servers, keep refreshed ones over stale ones, and the one
+    // with the lowest port otherwise.
+    const bool listed_stale = state.listed_servers[index].stale;
+    if (listed_stale != stale
+            ? listed_stale
+            : GetPortFromAddress(server.address) <
+                  GetPortFromAddress(servers[index].address)) {
+      state.listed_addresses.erase(servers[index].address);
+      state.listed_addresses[server.address] = index;
+      state.listed_servers[index].stale = stale;
+      state.listed_results[index] = ToModelResult(server);
+      servers[index] = std::move(server);
+    }
+    return;
+  }
+
+  const size_t index = servers.size();
+  state.listed_fingerprints.emplace(fingerprint, index);
+  state.listed_addresses[server.address] = index;
+  state.listed_servers.push_back({fingerprint, stale});
+  state.listed_results.push_back(ToModelResult(server));
+  servers.push_back(std::move(server));
+}
+
+void Quake3Game::UnlistServer(PartialResultsState& state, size_t index) {
+  auto& servers = *last_response_results_;
+
+  const auto erase_fingerprint = [&](size_t erased_index) {
+    auto [it, end] = state.listed_fingerprints.equal_range(
+        state.listed_servers[erased_index].fingerprint);
+    for (; it != end; ++it) {
+      if (it->second == erased_index) {
+        state.listed_fingerprints.erase(it);
+        return;
       }
+    }
+  };
 
-      model::GameServerLobbyResult entry;
-      entry.result_fields = {
-          server.address,
-          server.game_type,
-          server.hostname,
-          server.map,
-          std::to_string(server.players) + "/" +
-              std::to_string(server.max_players),
-          std::to_string(humans) + "/" + std::to_string(server.max_players),
-          std::to_string(server.ping)};
-      entry.metadata = server.metadata;
-      model_response.results.lobbies.push_back(std::move(entry));
-      cached_results.push_back(std::move(server));
+  erase_fingerprint(index);
+  state.listed_addresses.erase(servers[index].address);
+
+  // Moves the last server into the gap, so that no other indices change.
+  const size_t last_index = servers.size() - 1;
+  if (index != last_index) {
+    erase_fingerprint(last_index);
+    state.listed_fingerprints.emplace(
+        state.listed_servers[last_index].fingerprint, index);
+    state.listed_addresses[servers[last_index].address] = index;
+
+    servers[index] = std::move(servers[last_index]);
+    state.listed_servers[index] = state.listed_servers[last_index];
+    state.listed_results[index] = std::move(state.listed_results[last_index]);
+  }
+  servers.pop_back();
+  state.listed_servers.pop_back();
+  state.listed_results.pop_back();
+}
+
+void Quake3Game::OnPartialServersReceived(
+    std::shared_ptr<PartialResultsState> state,
+    base::RepeatingCallback<void(model::GameSearchResults)>
+        partial_results_callback,
+    std::vector<backend::Quake3ServerResult> servers) {
+  // Late replies of a previous search would replace the current results.
+  if (state->search_id != last_search_id_)
+    return;
+
+  if (!state->listing_started) {
+    StartListingServers(*state);
+  }
+
+  SmoothPings(servers, &state->smoothed_addresses);
+  state->received_count += servers.size();
+  for (auto& server : servers) {
+    ListServer(*state, std::move(server), /*stale=*/false);
+  }
+
+  model::GameSearchResults results;
+  results.lobbies = state->listed_results;
+
+  if (state->search_done) {
+    SetStatusText(std::string("Found ") +
+                  std::to_string(results.lobbies.size()) +
+                  std::string(" Quake 3 servers"));
+  } else if (state->received_count > 0 || state->stale_count == 0) {
+    SetStatusText(std::string("Searching Quake 3 servers, found ") +
+                  std::to_string(results.lobbies.size()) + " so far...");
+  }
+  partial_results_callback.Run(std::move(results));
+}
+
+void Quake3Game::OnMasterSearchDone(
+    int search_id,
+    std::shared_ptr<PartialResultsState> state,
+    base::OnceCallback<void(model::SearchResponse)> on_done_callback,
+    base::OnceCallback<void(model::GamePlayersResults)> players_callback,
+    backend::Quake3MasterSearchResponse response) {
+  if (response.result.status != backend::Result::Status::kOk) {
+    std::move(on_done_callback)
+        .Run(model::SearchResponse{
+            model::SearchResult::kError, response.result.error, {}, {}});
+    return;
+  }
+
+  // Servers already passed to `OnPartialServersReceived()` come again here.
+  SmoothPings(response.servers,
+              state ? &state->smoothed_addresses : nullptr);
+
+  model::SearchResponse model_response;
+  model_response.result = model::SearchResult::kOk;
+
+  // Results of a search that was superseded by a newer one are only passed to
+  // `on_done_callback`, as the newer one may be listing servers already.
+  const bool is_latest_search = search_id == last_search_id_;
+  std::vector<backend::Quake3ServerResult> superseded_servers;
+
+  if (state && is_latest_search) {
+    // Late replies are merged with these, so these are listed from scratch
+    // (without stale servers).
+    state->search_done = true;
+    state->stale_servers.clear();
+    StartListingServers(*state);
+    for (auto& server : response.servers) {
+      ListServer(*state, std::move(server), /*stale=*/false);
+    }
+    model_response.results.lobbies = state->listed_results;
+  } else {
+    auto servers = DeduplicateServers(std::move(response.servers));
+    for (auto& server : servers) {
+      model_response.results.lobbies.push_back(ToModelResult(server));
+    }
+    if (is_latest_search) {
+      last_response_results_ = std::move(servers);
+    } else {
+      superseded_servers = std::move(servers);
     }
   }
 
-  last_response_results_ = std::move(cached_results);
+  const auto& servers =
+      is_latest_search ? *last_response_results_ : superseded_servers;
+  if (is_latest_search) {
+    servers_cache_.Save(servers);
+  }
 
   if (players_callback) {
     model::GamePlayersResults players_results;
-    for (const auto& server : *last_response_results_) {
+    for (const auto& server : servers) {
       int humans = 0;
       for (const auto& member : server.members) {
         if (member.ping > 0)
@@ -759,9 +1275,15 @@ void Quake3Game::OnMasterSearchDone(
     std::move(players_callback).Run(std::move(players_results));
   }
 
-  SetStatusText(std::string("Found ") +
-                std::to_string(model_response.results.lobbies.size()) +
-                std::string(" Quake 3 servers"));
+  std::string status_text =
+      std::string("Found ") +
+      std::to_string(model_response.results.lobbies.size()) +
+      std::string(" Quake 3 servers");
+  if (response.skipped_probes > 0) {
+    status_text += " (skipped " + std::to_string(response.skipped_probes) +
+                   " unresponsive)";
+  }
+  SetStatusText(status_text);
   std::move(on_done_callback).Run(std::move(model_response));
 }
 
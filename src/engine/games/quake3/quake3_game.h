@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "base/callback.h"
@@ -10,16 +14,22 @@
 #include "engine/backends/quake3/quake3_master_backend.h"
 #include "engine/games/base_game.h"
 #include "engine/games/quake3/quake3_data.h"
+#include "engine/games/quake3/quake3_servers_cache.h"
 #include "models/game.h"
 #include "models/search.h"
 
+namespace engine::backend {
+class RttCache;
+}  // namespace engine::backend
+
 namespace engine::game {
 
 class Quake3Game : public BaseGame {
  public:
   Quake3Game(SetStatusTextCallback set_status_text,
              ReportMessageCallback report_message,
-             nlohmann::json game_config);
+             nlohmann::json game_config,
+             backend::RttCache* rtt_cache);
   ~Quake3Game() override;
 
   model::Game GetModel() const override;
@@ -50,7 +60,59 @@ class Quake3Game : public BaseGame {
     std::atomic<size_t> queried_servers{0};
   };
 
+  struct PartialResultsState {
+    // Only results of the latest search are shown.
+    int search_id = 0;
+    // Cached servers shown until they are refreshed, moved to the listed
+    // servers along with the first batch.
+    std::vector<backend::Quake3ServerResult> stale_servers;
+    size_t stale_count = 0;
+    size_t received_count = 0;
+
+    // Servers are deduplicated as batches arrive into `last_response_results_`.
+    // These are kept in the same order, so that each batch is merged without
+    // going over the servers listed before it.
+    struct ListedServer {
+      uint64_t fingerprint = 0;
+      bool stale = false;
+    };
+    bool listing_started = false;
+    std::vector<ListedServer> listed_servers;
+    std::vector<model::GameServerLobbyResult> listed_results;
+    std::unordered_multimap<uint64_t, size_t> listed_fingerprints;
+    std::unordered_map<std::string, size_t> listed_addresses;
+
+    // Partial results received after this are late replies, which the backend
+    // didn't wait for.
+    bool search_done = false;
+
+    // Servers whose ping of this search was already added to the RTT cache.
+    std::unordered_set<std::string> smoothed_addresses;
+  };
+
+  void ApplyProbeSettings();
+  void StartListingServers(PartialResultsState& state);
+  void ListServer(PartialResultsState& state,
+                  backend::Quake3ServerResult server,
+                  bool stale);
+  void UnlistServer(PartialResultsState& state, size_t index);
+  std::vector<backend::Quake3KnownServer> GetKnownServers() const;
+  // Adds the pings of `servers` to the RTT cache and replaces them with the
+  // smoothed values. Servers in `smoothed_addresses` (optional) were added
+  // already, and are added there otherwise.
+  void SmoothPings(std::vector<backend::Quake3ServerResult>& servers,
+                   std::unordered_set<std::string>* smoothed_addresses);
+  void OnPartialServersReceived(
+      std::shared_ptr<PartialResultsState> state,
+      base::RepeatingCallback<void(model::GameSearchResults)>
+          partial_results_callback,
+      std::vector<backend::Quake3ServerResult> servers);
+  void OnServerStatusReceived(
+      base::OnceCallback<void(model::SearchDetailsResponse)> on_done_callback,
+      std::optional<backend::Quake3ServerResult> server);
   void OnMasterSearchDone(
+      int search_id,
+      std::shared_ptr<PartialResultsState> state,
       base::OnceCallback<void(model::SearchResponse)> on_done_callback,
       base::OnceCallback<void(model::GamePlayersResults)> players_callback,
       backend::Quake3MasterSearchResponse response);
@@ -66,8 +128,14 @@ class Quake3Game : public BaseGame {
 
   quake3::Quake3Config config_;
   std::unique_ptr<backend::Quake3MasterBackend> master_backend_;
+  backend::RttCache* rtt_cache_;
   std::optional<std::vector<backend::Quake3ServerResult>>
       last_response_results_;
+  quake3::Quake3ServersCache servers_cache_;
+  // Results of the previous session's last refresh, consumed by the first
+  // search.
+  std::optional<quake3::Quake3CachedServers> cached_servers_;
+  int last_search_id_ = 0;
 
   base::WeakPtr<Quake3Game> weak_this_;
   base::WeakPtrFactory<Quake3Game> weak_factory_;
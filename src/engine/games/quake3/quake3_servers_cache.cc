@@ -0,0 +1,134 @@
+#include "engine/games/quake3/quake3_servers_cache.h"
+
+#include <cstdint>
+
+#include "base/callback.h"
+#include "base/logging.h"
+#include "nlohmann/json.hpp"
+#include "utils/msgpack_file.h"
+
+namespace engine::game::quake3 {
+
+namespace {
+const char* kCacheFilePath = "quake3_servers.dat";
+const int kCacheVersion = 2;
+const auto kMaxCacheAge = std::chrono::days(7);
+
+// Servers are stored as arrays instead of objects to keep the file compact:
+// [address, hostname, map, players, max_players, game_type, ping, humans,
+//  metadata, has_members, [[score, ping, name], ...]]
+nlohmann::json ServerToJson(const backend::Quake3ServerResult& server) {
+  nlohmann::json members = nlohmann::json::array();
+  for (const auto& member : server.members) {
+    members.push_back({member.score, member.ping, member.name});
+  }
+
+  return nlohmann::json::array({
+      server.address,
+      server.hostname,
+      server.map,
+      server.players,
+      server.max_players,
+      server.game_type,
+      server.ping,
+      server.humans ? nlohmann::json(*server.humans) : nlohmann::json(),
+      server.metadata,
+      server.has_members,
+      std::move(members),
+  });
+}
+
+backend::Quake3ServerResult ServerFromJson(const nlohmann::json& in) {
+  backend::Quake3ServerResult server;
+  server.address = in.at(0).get<std::string>();
+  server.hostname = in.at(1).get<std::string>();
+  server.map = in.at(2).get<std::string>();
+  server.players = in.at(3).get<int>();
+  server.max_players = in.at(4).get<int>();
+  server.game_type = in.at(5).get<std::string>();
+  server.ping = in.at(6).get<int>();
+  if (!in.at(7).is_null())
+    server.humans = in.at(7).get<int>();
+  server.metadata = in.at(8).get<std::map<std::string, std::string>>();
+  server.has_members = in.at(9).get<bool>();
+  for (const auto& member : in.at(10)) {
+    server.members.push_back(backend::Quake3ServerResult::Member{
+        member.at(0).get<int>(),
+        member.at(1).get<int>(),
+        member.at(2).get<std::string>(),
+    });
+  }
+  return server;
+}
+
+void SaveOnIoThread(std::vector<backend::Quake3ServerResult> servers) {
+  nlohmann::json json_servers = nlohmann::json::array();
+  for (const auto& server : servers) {
+    json_servers.push_back(ServerToJson(server));
+  }
+
+  util::WriteMsgpackFile(
+      kCacheFilePath,
+      nlohmann::json{
+          {"version", kCacheVersion},
+          {"timestamp",
+           std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+               .count()},
+          {"servers", std::move(json_servers)},
+      });
+}
+}  // namespace
+
+Quake3ServersCache::Quake3ServersCache() {
+  io_thread_.Start();
+}
+
+Quake3ServersCache::~Quake3ServersCache() {
+  io_thread_.Stop();
+}
+
+std::optional<Quake3CachedServers> Quake3ServersCache::Load() const {
+  const auto cache = util::ReadMsgpackFile(kCacheFilePath);
+  if (!cache) {
+    LOG(INFO) << "No readable Quake 3 servers cache";
+    return std::nullopt;
+  }
+
+  try {
+    if (cache->value("version", 0) != kCacheVersion) {
+      LOG(INFO) << "Ignoring Quake 3 servers cache in unsupported version";
+      return std::nullopt;
+    }
+
+    Quake3CachedServers cached_servers;
+    cached_servers.timestamp = std::chrono::system_clock::time_point{
+        std::chrono::seconds{cache->at("timestamp").get<int64_t>()}};
+    if (std::chrono::system_clock::now() - cached_servers.timestamp >
+        kMaxCacheAge) {
+      LOG(INFO) << "Ignoring outdated Quake 3 servers cache";
+      return std::nullopt;
+    }
+
+    const auto& servers = cache->at("servers");
+    cached_servers.servers.reserve(servers.size());
+    for (const auto& server : servers) {
+      cached_servers.servers.push_back(ServerFromJson(server));
+    }
+
+    LOG(INFO) << "Loaded " << cached_servers.servers.size()
+              << " Quake 3 servers from cache";
+    return cached_servers;
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to load Quake 3 servers cache: " << e.what();
+    return std::nullopt;
+  }
+}
+
+void Quake3ServersCache::Save(
+    std::vector<backend::Quake3ServerResult> servers) {
+  io_thread_.TaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&SaveOnIoThread, std::move(servers)));
+}
+
+}  // namespace engine::game::quake3
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "base/threading/thread.h"
+#include "engine/backends/quake3/quake3_master_backend.h"
+
+namespace engine::game::quake3 {
+
+struct Quake3CachedServers {
+  std::chrono::system_clock::time_point timestamp;
+  std::vector<backend::Quake3ServerResult> servers;
+};
+
+// Persists results of the last successful refresh on disk, so that they can be
+// shown right after startup while a new refresh is still running.
+class Quake3ServersCache {
+ public:
+  Quake3ServersCache();
+  ~Quake3ServersCache();
+
+  // Returns nothing if there is no cache file, it can't be parsed or is too
+  // old to be useful.
+  std::optional<Quake3CachedServers> Load() const;
+  // Writes the file on a background thread, so that refreshes aren't held up
+  // by disk I/O. Pending writes complete before destruction.
+  void Save(std::vector<backend::Quake3ServerResult> servers);
+
+ private:
+  base::Thread io_thread_;
+};
+
+}  // namespace engine::game::quake3
@@ -15,6 +15,9 @@ struct SearchRequest {
   std::string game_name;
   GameFilters search_filters;
   base::OnceCallback<void(GamePlayersResults)> players_callback;
+  // Optional. Games that find results incrementally call this with all
+  // results found so far, before the final response is delivered.
+  base::RepeatingCallback<void(GameSearchResults)> partial_results_callback;
 };
 
 enum SearchResult {
@@ -269,14 +269,21 @@ void WxGamePage::TriggerSearchIfPossible() {
     players_list_->Refresh();
   }
 
+  const int search_id = ++last_search_id_;
+  final_results_delivered_ = false;
+
   auto current_filters = GetCurrentGameFilters();
   event_handler_->OnSearchLobbiesAndServers(
       model::SearchRequest{
           game_model_.name,
           std::move(current_filters),
           base::BindOnce(&WxGamePage::OnSearchLobbiesPlayersDone, weak_this_),
+          base::BindRepeating(
+              &WxGamePage::OnSearchLobbiesAndServersPartialResults,
+              weak_this_, search_id),
       },
-      base::BindOnce(&WxGamePage::OnSearchLobbiesAndServersDone, weak_this_));
+      base::BindOnce(&WxGamePage::OnSearchLobbiesAndServersDone, weak_this_,
+                     search_id));
 }
 
 void WxGamePage::ConnectToCurrentlySelectedLobbyIfPossible() {
@@ -840,7 +847,26 @@ void WxGamePage::OnPlayersRowEntered(wxDataViewEvent& event) {
   }
 }
 
-void WxGamePage::OnSearchLobbiesAndServersDone(model::SearchResponse response) {
+void WxGamePage::OnSearchLobbiesAndServersPartialResults(
+    int search_id,
+    model::GameSearchResults results) {
+  // Games may still pass late replies after finishing the search early, which
+  // would change the final results under auto search.
+  if (search_id != last_search_id_ || final_results_delivered_) {
+    return;
+  }
+
+  last_response_results_ = std::move(results);
+  RefreshResultsList();
+}
+
+void WxGamePage::OnSearchLobbiesAndServersDone(int search_id,
+                                               model::SearchResponse response) {
+  if (search_id != last_search_id_) {
+    return;
+  }
+
+  final_results_delivered_ = true;
   search_button_->Enable();
   results_list_->SetBackgroundColour(theme_colors_.ListLoadedBg);
   results_list_->Refresh();
@@ -959,8 +985,10 @@ void WxGamePage::RefreshResultsList() {
       lobbies_metadata_[lobby_id] = result.metadata;
     }
 
+    const bool stale = result.metadata.contains("stale");
     results_list_->AppendItem(
-        wxVector<wxVariant>{item_values.begin(), item_values.end()});
+        wxVector<wxVariant>{item_values.begin(), item_values.end()},
+        stale ? WxResultsListModel::kStaleRowData : 0);
   }
 
   // Select previously selected one, if still exists, otherwise clear memory
@@ -972,8 +1000,8 @@ void WxGamePage::RefreshResultsList() {
     }
   }
 
-  // Check autosearch options
-  if (autosearch_options_) {
+  // Check autosearch options, but only once the final results are in
+  if (autosearch_options_ && final_results_delivered_) {
     if (size_t count = ResultsMatchingAutoSearchOptions(filtered_results);
         count > 0) {
       on_autosearch_found_.Run(count);
@@ -65,7 +65,11 @@ class WxGamePage {
   void NavigateToPlayer(std::string player_id);
   void ShowLobbyDetails(wxString lobby_id);
   void OnPlayersRowEntered(wxDataViewEvent& event);
-  void OnSearchLobbiesAndServersDone(model::SearchResponse response);
+  void OnSearchLobbiesAndServersPartialResults(
+      int search_id,
+      model::GameSearchResults results);
+  void OnSearchLobbiesAndServersDone(int search_id,
+                                     model::SearchResponse response);
   void OnSearchLobbiesPlayersDone(model::GamePlayersResults players);
   void RequestSelectedLobbyDetails(bool wait_for_full_details);
   void OnServerLobbyDetailsReceived(std::string result_id,
@@ -97,6 +101,11 @@ class WxGamePage {
   wxButton* search_button_;
 
   model::GameSearchResults last_response_results_;
+  int last_search_id_ = 0;
+  // Set once the final results of `last_search_id_` arrive. Until then, shown
+  // results are partial and still changing, so auto search doesn't check them.
+  // Partial results arriving after that are dropped.
+  bool final_results_delivered_ = false;
   model::LobbyConnectorCreateCallback create_lobby_connector_;
   std::optional<std::string> selected_result_id_;
   std::optional<model::SearchDetailsResponse> last_search_details_;
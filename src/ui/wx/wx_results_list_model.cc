@@ -1,5 +1,7 @@
 #include "ui/wx/wx_results_list_model.h"
 
+#include "wx/settings.h"
+
 namespace ui::wx {
 
 WxResultsListModel::WxResultsListModel(
@@ -94,4 +96,16 @@ int WxResultsListModel::Compare(const wxDataViewItem& item1,
   return result;
 }
 
+bool WxResultsListModel::GetAttrByRow(unsigned int row,
+                                      unsigned int column,
+                                      wxDataViewItemAttr& attr) const {
+  if (GetItemData(GetItem(row)) != kStaleRowData) {
+    return false;
+  }
+
+  attr.SetColour(wxSystemSettings::GetColour(wxSYS_COLOUR_GRAYTEXT));
+  attr.SetItalic(true);
+  return true;
+}
+
 }  // namespace ui::wx
@@ -10,6 +10,10 @@ namespace ui::wx {
 
 class WxResultsListModel : public wxDataViewListStore {
  public:
+  // Passed as item data of rows showing results that weren't refreshed yet
+  // (with "stale" metadata), which are greyed out.
+  static constexpr wxUIntPtr kStaleRowData = 1;
+
   WxResultsListModel(std::vector<model::GameResultsColumnFormat> formats);
   ~WxResultsListModel() override;
 
@@ -0,0 +1,50 @@
+#include "utils/msgpack_file.h"
+
+#include <fstream>
+#include <iterator>
+
+#include "base/logging.h"
+
+namespace util {
+
+std::optional<nlohmann::json> ReadMsgpackFile(
+    const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+
+  try {
+    return nlohmann::json::from_msgpack(std::istreambuf_iterator<char>(file),
+                                        std::istreambuf_iterator<char>());
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to parse " << path.string() << ": " << e.what();
+    return std::nullopt;
+  }
+}
+
+bool WriteMsgpackFile(const std::filesystem::path& path,
+                      const nlohmann::json& json) {
+  auto temp_path = path;
+  temp_path += ".tmp";
+
+  try {
+    const auto data = nlohmann::json::to_msgpack(json);
+    {
+      std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(data.data()),
+                 static_cast<std::streamsize>(data.size()));
+      if (!file) {
+        LOG(ERROR) << "Failed to write " << temp_path.string();
+        return false;
+      }
+    }
+    std::filesystem::rename(temp_path, path);
+    return true;
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to save " << path.string() << ": " << e.what();
+    return false;
+  }
+}
+
+}  // namespace util
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+
+#include "nlohmann/json.hpp"
+
+namespace util {
+
+// Returns nothing if the file doesn't exist or isn't valid msgpack.
+std::optional<nlohmann::json> ReadMsgpackFile(
+    const std::filesystem::path& path);
+
+// Writes through a temporary file that is then renamed over `path`, so that a
+// crash in the middle of writing doesn't leave a truncated file behind.
+// Blocks on disk I/O, so shouldn't be called on latency-sensitive sequences.
+bool WriteMsgpackFile(const std::filesystem::path& path,
+                      const nlohmann::json& json);
+
+}  // namespace util